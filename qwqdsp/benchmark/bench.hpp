@@ -0,0 +1,44 @@
+#pragma once
+#include <chrono>
+#include <cstddef>
+
+namespace qwqdsp::benchmark {
+/**
+ * @brief 重复调用func直到超过min_seconds
+ * @return 每次调用的平均纳秒
+ */
+template<class Func>
+double MeasureNs(Func&& func, double min_seconds = 0.2) {
+    using Clock = std::chrono::steady_clock;
+    // 预热
+    for (size_t i = 0; i < 8; ++i) {
+        func();
+    }
+    size_t num_run = 1;
+    for (;;) {
+        auto const begin = Clock::now();
+        for (size_t i = 0; i < num_run; ++i) {
+            func();
+        }
+        std::chrono::duration<double> const elapsed = Clock::now() - begin;
+        if (elapsed.count() >= min_seconds) {
+            return elapsed.count() * 1e9 / static_cast<double>(num_run);
+        }
+        num_run *= 2;
+    }
+}
+
+/**
+ * @brief 防止编译器把结果优化掉
+ */
+template<class T>
+inline void DoNotOptimize(T const& value) {
+#if defined(__GNUC__) || defined(__clang__)
+    asm volatile("" : : "g"(value) : "memory");
+#else
+    static volatile T sink{};
+    sink = value;
+    static_cast<void>(sink);
+#endif
+}
+}
\ No newline at end of file
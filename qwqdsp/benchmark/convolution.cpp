@@ -0,0 +1,249 @@
+#include <cmath>
+#include <cstddef>
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include "bench.hpp"
+#include "qwqdsp/fx/matrix_convolution.hpp"
+#include "qwqdsp/fx/offline_convolution.hpp"
+#include "qwqdsp/fx/partitioned_convolution.hpp"
+#include "qwqdsp/fx/uniform_convolution.hpp"
+#include "qwqdsp/spectral/frequency_delay_line.hpp"
+
+static constexpr float kSampleRate = 48000.0f;
+
+// 处理一秒的音频，每次latency个采样
+template<class Conv>
+static double MeasureSecond(Conv& conv, std::vector<float>& audio, size_t block_size) {
+    return qwqdsp::benchmark::MeasureNs([&] {
+        for (size_t i = 0; i + block_size <= audio.size(); i += block_size) {
+            conv.Process(std::span<float>{audio.data() + i, block_size});
+        }
+        qwqdsp::benchmark::DoNotOptimize(audio[1]);
+    });
+}
+
+// 按实时的速度处理，返回单个block的最长耗时
+static double MeasurePeakNs(qwqdsp::fx::PartitionedConvolution& conv, std::vector<float>& audio, size_t block_size) {
+    using Clock = std::chrono::steady_clock;
+    const auto period = std::chrono::duration<double>(static_cast<double>(block_size) / kSampleRate);
+    auto next = Clock::now();
+    double peak = 0.0;
+    for (size_t i = 0; i + block_size <= audio.size(); i += block_size) {
+        auto const begin = Clock::now();
+        conv.Process(std::span<float>{audio.data() + i, block_size});
+        std::chrono::duration<double> const elapsed = Clock::now() - begin;
+        peak = std::max(peak, elapsed.count() * 1e9);
+        next += std::chrono::duration_cast<Clock::duration>(period);
+        std::this_thread::sleep_until(next);
+    }
+    return peak;
+}
+
+int main() {
+    std::mt19937 rng{42};
+    std::uniform_real_distribution<float> dist{-1.0f, 1.0f};
+
+    std::vector<float> audio(static_cast<size_t>(kSampleRate));
+    for (auto& s : audio) {
+        s = dist(rng);
+    }
+
+    // 频谱乘加: 原来每个分区取模找SplitSpectrum的循环和连续存放的simd_complex_mac对比
+    std::printf("%-12s %8s %8s %10s %10s\n", "mac", "bins", "parts", "ns/hop", "GFLOPS");
+    for (size_t num_bins : {129, 513}) {
+        for (size_t num_partitions : {16, 256}) {
+            using Frame = qwqdsp::spectral::SplitSpectrum<>;
+            std::vector<Frame> ir_frames(num_partitions);
+            std::vector<Frame> input_frames(num_partitions);
+            qwqdsp::spectral::SpectrumArray ir_array;
+            qwqdsp::spectral::FrequencyDelayLine fdl;
+            ir_array.Resize(num_partitions, num_bins);
+            fdl.Resize(num_partitions, num_bins);
+            for (size_t p = 0; p < num_partitions; ++p) {
+                for (auto* f : {&ir_frames[p], &input_frames[p]}) {
+                    f->Resize(num_bins);
+                    for (size_t i = 0; i < num_bins; ++i) {
+                        f->real[i] = dist(rng);
+                        f->imag[i] = dist(rng);
+                    }
+                }
+                ir_array.Set(p, ir_frames[p]);
+                fdl.Push(input_frames[p]);
+            }
+            Frame output;
+            output.Resize(num_bins);
+            size_t wpos = 0;
+            // 复数乘加8个flop
+            const double flops = 8.0 * static_cast<double>(num_bins * num_partitions);
+
+            const double loop_ns = qwqdsp::benchmark::MeasureNs([&] {
+                output.Multiply(input_frames[wpos], ir_frames[0]);
+                for (size_t i = 1; i < num_partitions; ++i) {
+                    size_t idx = wpos + num_partitions - i;
+                    if (idx >= num_partitions) {
+                        idx -= num_partitions;
+                    }
+                    output.MultiplyAccumulate(input_frames[idx], ir_frames[i]);
+                }
+                wpos = wpos + 1 >= num_partitions ? 0 : wpos + 1;
+                qwqdsp::benchmark::DoNotOptimize(output.real[1]);
+            });
+            std::printf("%-12s %8zu %8zu %10.1f %10.2f\n", "loop", num_bins, num_partitions, loop_ns, flops / loop_ns);
+
+            const double fdl_ns = qwqdsp::benchmark::MeasureNs([&] {
+                fdl.MultiplyAccumulate(ir_array, output, false);
+                qwqdsp::benchmark::DoNotOptimize(output.real[1]);
+            });
+            std::printf("%-12s %8zu %8zu %10.1f %10.2f\n", "fdl", num_bins, num_partitions, fdl_ns, flops / fdl_ns);
+        }
+    }
+
+    // cpu%是处理一秒音频所需的时间占一秒的比例
+    std::printf("\n%-12s %8s %8s %10s %10s\n", "impl", "latency", "ir(s)", "ns/block", "cpu%");
+    for (float ir_seconds : {0.5f, 3.0f}) {
+        std::vector<float> ir(static_cast<size_t>(kSampleRate * ir_seconds));
+        for (size_t i = 0; i < ir.size(); ++i) {
+            ir[i] = dist(rng) * std::exp(-6.0f * static_cast<float>(i) / static_cast<float>(ir.size()));
+        }
+        for (size_t latency : {64, 256}) {
+            const double num_blocks = static_cast<double>(audio.size() / latency);
+
+            qwqdsp::fx::UniformConvolution uniform;
+            uniform.Init(latency);
+            uniform.SetIR(ir);
+            const double uniform_ns = MeasureSecond(uniform, audio, latency);
+            std::printf("%-12s %8zu %8.1f %10.1f %10.2f\n", "uniform", latency, ir_seconds, uniform_ns / num_blocks, uniform_ns * 1e-7);
+
+            qwqdsp::fx::PartitionedConvolution partitioned;
+            partitioned.Init(latency);
+            partitioned.SetIR(ir);
+            const double partitioned_ns = MeasureSecond(partitioned, audio, latency);
+            std::printf("%-12s %8zu %8.1f %10.1f %10.2f\n", "partitioned", latency, ir_seconds, partitioned_ns / num_blocks, partitioned_ns * 1e-7);
+
+            qwqdsp::fx::PartitionedConvolution zero_latency;
+            zero_latency.Init(latency, 8192, true);
+            zero_latency.SetIR(ir);
+            const double zero_latency_ns = MeasureSecond(zero_latency, audio, latency);
+            std::printf("%-12s %8zu %8.1f %10.1f %10.2f\n", "zero-latency", latency, ir_seconds, zero_latency_ns / num_blocks, zero_latency_ns * 1e-7);
+        }
+    }
+
+    // 峰值: 实时速度下单个block的最长耗时，后台线程计算>=1024的分区
+    std::printf("\n%-12s %8s %8s %10s %10s\n", "impl", "latency", "ir(s)", "peak ns", "miss");
+    {
+        std::vector<float> ir(static_cast<size_t>(kSampleRate * 3.0f));
+        for (size_t i = 0; i < ir.size(); ++i) {
+            ir[i] = dist(rng) * std::exp(-6.0f * static_cast<float>(i) / static_cast<float>(ir.size()));
+        }
+        constexpr size_t kLatency = 64;
+        for (size_t async : {0, 1024}) {
+            qwqdsp::fx::PartitionedConvolution conv;
+            conv.Init(kLatency);
+            conv.SetAsync(async);
+            conv.SetIR(ir);
+            const double peak = MeasurePeakNs(conv, audio, kLatency);
+            std::printf("%-12s %8zu %8.1f %10.1f %10zu\n", async == 0 ? "sync" : "async", kLatency, 3.0, peak, conv.NumDeadlineMiss());
+        }
+    }
+
+    // true stereo: 4个UniformConvolution和2x2的MatrixConvolution对比
+    std::printf("\n%-12s %8s %8s %10s %10s\n", "2x2", "latency", "ir(s)", "ns/block", "cpu%");
+    {
+        constexpr size_t kLatency = 256;
+        constexpr float kIRSeconds = 0.5f;
+        std::vector<float> irs[4];
+        for (auto& ir : irs) {
+            ir.resize(static_cast<size_t>(kSampleRate * kIRSeconds));
+            for (size_t i = 0; i < ir.size(); ++i) {
+                ir[i] = dist(rng) * std::exp(-6.0f * static_cast<float>(i) / static_cast<float>(ir.size()));
+            }
+        }
+        const double num_blocks = static_cast<double>(audio.size() / kLatency);
+        std::vector<float> left(audio);
+        std::vector<float> right(audio);
+        std::vector<float> paths[4];
+        for (auto& p : paths) {
+            p.resize(kLatency);
+        }
+
+        qwqdsp::fx::UniformConvolution separate[4];
+        for (size_t i = 0; i < 4; ++i) {
+            separate[i].Init(kLatency);
+            separate[i].SetIR(irs[i]);
+        }
+        const double separate_ns = qwqdsp::benchmark::MeasureNs([&] {
+            for (size_t i = 0; i + kLatency <= audio.size(); i += kLatency) {
+                for (size_t p = 0; p < 4; ++p) {
+                    const auto& in = p % 2 == 0 ? left : right;
+                    std::copy_n(in.begin() + i, kLatency, paths[p].begin());
+                    separate[p].Process(paths[p]);
+                }
+                for (size_t j = 0; j < kLatency; ++j) {
+                    left[i + j] = paths[0][j] + paths[1][j];
+                    right[i + j] = paths[2][j] + paths[3][j];
+                }
+            }
+            qwqdsp::benchmark::DoNotOptimize(left[1]);
+        });
+        std::printf("%-12s %8zu %8.1f %10.1f %10.2f\n", "uniform x4", kLatency, kIRSeconds, separate_ns / num_blocks, separate_ns * 1e-7);
+
+        qwqdsp::fx::MatrixConvolution matrix;
+        matrix.Init(2, 2, kLatency);
+        for (size_t i = 0; i < 4; ++i) {
+            matrix.SetIR(i % 2, i / 2, irs[i]);
+        }
+        const double matrix_ns = qwqdsp::benchmark::MeasureNs([&] {
+            for (size_t i = 0; i + kLatency <= audio.size(); i += kLatency) {
+                const std::span<const float> inputs[] {{left.data() + i, kLatency}, {right.data() + i, kLatency}};
+                const std::span<float> outputs[] {{left.data() + i, kLatency}, {right.data() + i, kLatency}};
+                matrix.Process(inputs, outputs);
+            }
+            qwqdsp::benchmark::DoNotOptimize(left[1]);
+        });
+        std::printf("%-12s %8zu %8.1f %10.1f %10.2f\n", "matrix", kLatency, kIRSeconds, matrix_ns / num_blocks, matrix_ns * 1e-7);
+    }
+
+    // 离线: 一分钟的文件和3秒的IR，UniformConvolution流式处理和OfflineConvolution对比
+    std::printf("\n%-12s %8s %8s %10s\n", "offline", "file(s)", "ir(s)", "ms");
+    {
+        constexpr float kFileSeconds = 60.0f;
+        constexpr float kIRSeconds = 3.0f;
+        std::vector<float> file(static_cast<size_t>(kSampleRate * kFileSeconds));
+        for (auto& s : file) {
+            s = dist(rng);
+        }
+        std::vector<float> ir(static_cast<size_t>(kSampleRate * kIRSeconds));
+        for (size_t i = 0; i < ir.size(); ++i) {
+            ir[i] = dist(rng) * std::exp(-6.0f * static_cast<float>(i) / static_cast<float>(ir.size()));
+        }
+
+        constexpr size_t kBlockSize = 4096;
+        qwqdsp::fx::UniformConvolution uniform;
+        uniform.Init(kBlockSize);
+        uniform.SetIR(ir);
+        const double uniform_ns = qwqdsp::benchmark::MeasureNs([&] {
+            std::vector<float> y(file.size() + ir.size() - 1);
+            std::copy(file.begin(), file.end(), y.begin());
+            for (size_t i = 0; i < y.size(); i += kBlockSize) {
+                uniform.Process(std::span<float>{y.data() + i, std::min(kBlockSize, y.size() - i)});
+            }
+            qwqdsp::benchmark::DoNotOptimize(y[1]);
+        });
+        std::printf("%-12s %8.1f %8.1f %10.1f\n", "uniform", kFileSeconds, kIRSeconds, uniform_ns * 1e-6);
+
+        for (size_t num_threads : {1, 0}) {
+            qwqdsp::fx::OfflineConvolution offline;
+            offline.SetNumThreads(num_threads);
+            const double offline_ns = qwqdsp::benchmark::MeasureNs([&] {
+                auto y = offline.Convolve(file, ir);
+                qwqdsp::benchmark::DoNotOptimize(y[1]);
+            });
+            std::printf("%-12s %8.1f %8.1f %10.1f\n", num_threads == 1 ? "offline x1" : "offline", kFileSeconds, kIRSeconds, offline_ns * 1e-6);
+        }
+    }
+}
\ No newline at end of file
@@ -0,0 +1,220 @@
+#include <algorithm>
+#include <cmath>
+#include <complex>
+#include <cstddef>
+#include <cstdio>
+#include <random>
+#include <utility>
+#include <vector>
+
+#include "bench.hpp"
+#include "qwqdsp/spectral/complex_fft.hpp"
+#include "qwqdsp/spectral/fixed_fft.hpp"
+#include "qwqdsp/spectral/real_fft.hpp"
+
+using qwqdsp::spectral::FFTBackend;
+
+static const char* BackendName(FFTBackend backend) {
+    switch (backend) {
+    case FFTBackend::kSimd:
+        return "simd";
+    case FFTBackend::kMixedRadix:
+        return "mixed";
+    default:
+        return "ooura";
+    }
+}
+
+// 按5Nlog2(N)算复数FFT的flops，实数FFT减半
+static double Mflops(size_t n, double ns, bool real) {
+    double flops = 5.0 * static_cast<double>(n) * std::log2(static_cast<double>(n));
+    if (real) {
+        flops *= 0.5;
+    }
+    return flops / ns * 1e3;
+}
+
+// 编译期固定点数和运行时点数的实数FFT对比
+template<size_t N>
+static void BenchFixed(std::mt19937& rng) {
+    std::uniform_real_distribution<float> dist{-1.0f, 1.0f};
+    std::vector<float> time(N);
+    for (auto& s : time) {
+        s = dist(rng);
+    }
+    std::vector<std::complex<float>> spectral(N / 2 + 1);
+
+    qwqdsp::spectral::RealFFTFixed<N> fixed;
+    double const fixed_ns = qwqdsp::benchmark::MeasureNs([&] {
+        fixed.FFT(time, spectral);
+        qwqdsp::benchmark::DoNotOptimize(spectral[1].real());
+    });
+    std::printf("%-8s %-6s %8zu %14.1f %10.1f\n", "real", "fixed", N, fixed_ns, Mflops(N, fixed_ns, true));
+
+    for (auto backend : {FFTBackend::kOoura, FFTBackend::kSimd}) {
+        qwqdsp::spectral::RealFFT<> fft;
+        fft.Init(N, backend);
+        double const ns = qwqdsp::benchmark::MeasureNs([&] {
+            fft.FFT(time, spectral);
+            qwqdsp::benchmark::DoNotOptimize(spectral[1].real());
+        });
+        std::printf("%-8s %-6s %8zu %14.1f %10.1f\n", "real", BackendName(backend), N, ns, Mflops(N, ns, true));
+    }
+
+    std::vector<std::complex<float>> block(N);
+    for (auto& s : block) {
+        s = {dist(rng), dist(rng)};
+    }
+    qwqdsp::spectral::ComplexFFTFixed<N> fixed_complex;
+    double const complex_ns = qwqdsp::benchmark::MeasureNs([&] {
+        fixed_complex.FFTInplace(block);
+        qwqdsp::benchmark::DoNotOptimize(block[1].real());
+    });
+    std::printf("%-8s %-6s %8zu %14.1f %10.1f\n", "complex", "fixed", N, complex_ns, Mflops(N, complex_ns, false));
+
+    qwqdsp::spectral::ComplexFFT<false> fft;
+    fft.Init(N, FFTBackend::kSimd);
+    double const simd_ns = qwqdsp::benchmark::MeasureNs([&] {
+        fft.FFTInplace(block);
+        qwqdsp::benchmark::DoNotOptimize(block[1].real());
+    });
+    std::printf("%-8s %-6s %8zu %14.1f %10.1f\n", "complex", "simd", N, simd_ns, Mflops(N, simd_ns, false));
+}
+
+template<size_t... kLog2>
+static void BenchFixedAll(std::mt19937& rng, std::index_sequence<kLog2...>) {
+    (BenchFixed<size_t{16} << kLog2>(rng), ...);
+}
+
+int main() {
+    std::mt19937 rng{42};
+    std::uniform_real_distribution<float> dist{-1.0f, 1.0f};
+
+    std::printf("%-8s %-6s %8s %14s %10s\n", "type", "impl", "size", "ns/fft", "MFLOPS");
+    for (size_t n = 64; n <= 65536; n *= 2) {
+        std::vector<float> time(n);
+        for (auto& s : time) {
+            s = dist(rng);
+        }
+
+        for (auto backend : {FFTBackend::kOoura, FFTBackend::kSimd}) {
+            qwqdsp::spectral::RealFFT<> fft;
+            fft.Init(n, backend);
+            std::vector<std::complex<float>> spectral(fft.NumBins());
+            double const ns = qwqdsp::benchmark::MeasureNs([&] {
+                fft.FFT(time, spectral);
+                qwqdsp::benchmark::DoNotOptimize(spectral[1].real());
+            });
+            std::printf("%-8s %-6s %8zu %14.1f %10.1f\n", "real", BackendName(backend), n, ns, Mflops(n, ns, true));
+        }
+
+        for (auto backend : {FFTBackend::kOoura, FFTBackend::kSimd}) {
+            qwqdsp::spectral::ComplexFFT<false> fft;
+            fft.Init(n, backend);
+            std::vector<std::complex<float>> spectral(fft.NumBins());
+            double const ns = qwqdsp::benchmark::MeasureNs([&] {
+                fft.FFT(std::span<const float>{time}, spectral);
+                qwqdsp::benchmark::DoNotOptimize(spectral[1].real());
+            });
+            std::printf("%-8s %-6s %8zu %14.1f %10.1f\n", "complex", BackendName(backend), n, ns, Mflops(n, ns, false));
+        }
+    }
+
+    // 非2的幂: mixed radix/Bluestein和补零到2的幂对比
+    std::printf("\n%-8s %-6s %8s %14s %10s\n", "size", "impl", "size", "ns/fft", "MFLOPS");
+    for (size_t n : {240, 480, 960, 1920, 1000, 1022}) {
+        std::vector<float> time(n);
+        for (auto& s : time) {
+            s = dist(rng);
+        }
+        qwqdsp::spectral::RealFFT<> fft;
+        fft.Init(n);
+        std::vector<std::complex<float>> spectral(fft.NumBins());
+        double const ns = qwqdsp::benchmark::MeasureNs([&] {
+            fft.FFT(time, spectral);
+            qwqdsp::benchmark::DoNotOptimize(spectral[1].real());
+        });
+        std::printf("%-8s %-6s %8zu %14.1f %10.1f\n", "real", BackendName(fft.Backend()), n, ns, Mflops(n, ns, true));
+
+        size_t padded = 1;
+        while (padded < n) {
+            padded *= 2;
+        }
+        for (auto backend : {FFTBackend::kOoura, FFTBackend::kSimd}) {
+            qwqdsp::spectral::RealFFT<> pow2;
+            pow2.Init(padded, backend);
+            std::vector<float> padded_time(padded);
+            std::vector<std::complex<float>> padded_spectral(pow2.NumBins());
+            double const pad_ns = qwqdsp::benchmark::MeasureNs([&] {
+                std::copy(time.begin(), time.end(), padded_time.begin());
+                pow2.FFT(padded_time, padded_spectral);
+                qwqdsp::benchmark::DoNotOptimize(padded_spectral[1].real());
+            });
+            std::printf("%-8s %-6s %8zu %14.1f %10.1f\n", "pad", BackendName(backend), padded, pad_ns, Mflops(padded, pad_ns, true));
+        }
+    }
+
+    // 精度: float和double对比，double的向量宽度只有一半
+    std::printf("\n%-8s %-6s %8s %14s %10s\n", "type", "impl", "size", "ns/fft", "MFLOPS");
+    for (size_t n = 256; n <= 16384; n *= 4) {
+        for (auto backend : {FFTBackend::kOoura, FFTBackend::kSimd}) {
+            std::vector<float> time(n);
+            for (auto& s : time) {
+                s = dist(rng);
+            }
+            qwqdsp::spectral::RealFFT<float> fft;
+            fft.Init(n, backend);
+            std::vector<std::complex<float>> spectral(fft.NumBins());
+            double const ns = qwqdsp::benchmark::MeasureNs([&] {
+                fft.FFT(time, spectral);
+                qwqdsp::benchmark::DoNotOptimize(spectral[1].real());
+            });
+            std::printf("%-8s %-6s %8zu %14.1f %10.1f\n", "float", BackendName(backend), n, ns, Mflops(n, ns, true));
+
+            std::vector<double> time_double(time.begin(), time.end());
+            qwqdsp::spectral::RealFFT<double> fft_double;
+            fft_double.Init(n, backend);
+            std::vector<std::complex<double>> spectral_double(fft_double.NumBins());
+            double const ns_double = qwqdsp::benchmark::MeasureNs([&] {
+                fft_double.FFT(time_double, spectral_double);
+                qwqdsp::benchmark::DoNotOptimize(spectral_double[1].real());
+            });
+            std::printf("%-8s %-6s %8zu %14.1f %10.1f\n", "double", BackendName(backend), n, ns_double, Mflops(n, ns_double, true));
+        }
+    }
+
+    // 小点数: 16 ~ 256
+    std::printf("\n%-8s %-6s %8s %14s %10s\n", "fixed", "impl", "size", "ns/fft", "MFLOPS");
+    BenchFixedAll(rng, std::make_index_sequence<5>{});
+
+    // 多通道: 逐个FFT和FFTBatch对比，ns是每个通道的平均
+    // 超过kSimdBatchMaxComplexSize之后FFTBatch内部也是逐个处理
+    constexpr size_t kNumChannels = 32;
+    std::printf("\n%-8s %-6s %8s %14s %10s\n", "batch", "impl", "size", "ns/channel", "MFLOPS");
+    for (size_t n = 16; n <= 1024; n *= 2) {
+        std::vector<float> time(n * kNumChannels);
+        for (auto& s : time) {
+            s = dist(rng);
+        }
+        qwqdsp::spectral::RealFFT<> fft;
+        fft.Init(n, FFTBackend::kSimd);
+        std::vector<qwqdsp::spectral::SplitSpectrum<>> spectral(kNumChannels);
+        for (auto& s : spectral) {
+            s.Resize(fft.NumBins());
+        }
+
+        double const loop_ns = qwqdsp::benchmark::MeasureNs([&] {
+            for (size_t c = 0; c < kNumChannels; ++c) {
+                fft.FFT(std::span<const float>{time}.subspan(c * n, n), spectral[c]);
+            }
+            qwqdsp::benchmark::DoNotOptimize(spectral.back().real[1]);
+        }) / kNumChannels;
+        std::printf("%-8s %-6s %8zu %14.1f %10.1f\n", "real", "loop", n, loop_ns, Mflops(n, loop_ns, true));
+
+        double const batch_ns = qwqdsp::benchmark::MeasureNs([&] {
+            fft.FFTBatch(time, n, spectral);
+            qwqdsp::benchmark::DoNotOptimize(spectral.back().real[1]);
+        }) / kNumChannels;
+        std::printf("%-8s %-6s %8zu %14.1f %10.1f\n", "real", "batch", n, batch_ns, Mflops(n, batch_ns, true));
+    }
+}
\ No newline at end of file
@@ -0,0 +1,279 @@
+#include <algorithm>
+#include <cstddef>
+#include <cstdio>
+#include <random>
+#include <span>
+#include <vector>
+
+#include "bench.hpp"
+#include "qwqdsp/filter/fir.hpp"
+#include "qwqdsp/filter/halfband.hpp"
+#include "qwqdsp/filter/polyphase.hpp"
+#include "qwqdsp/filter/window_fir.hpp"
+
+// 原来的实现: 每个batch移动整个缓冲区，然后逐个输出做标量内积
+template<size_t kBatchSize>
+class ScalarFIR {
+public:
+    void SetCoeff(std::span<const float> coeff) {
+        coeff_.assign(coeff.rbegin(), coeff.rend());
+        latch_.assign(coeff_.size() + kBatchSize - 1, 0.0f);
+    }
+
+    void Process(std::span<float> x) noexcept {
+        for (size_t pos = 0; pos < x.size(); pos += kBatchSize) {
+            const size_t num = std::min(kBatchSize, x.size() - pos);
+            for (size_t i = 0; i < latch_.size() - num; ++i) {
+                latch_[i] = latch_[i + num];
+            }
+            std::copy_n(x.begin() + pos, num, latch_.end() - num);
+            const float* history = latch_.data() + latch_.size() - num - coeff_.size() + 1;
+            for (size_t i = 0; i < num; ++i) {
+                float sum = 0.0f;
+                for (size_t j = 0; j < coeff_.size(); ++j) {
+                    sum += coeff_[j] * history[i + j];
+                }
+                x[pos + i] = sum;
+            }
+        }
+    }
+private:
+    std::vector<float> coeff_;
+    std::vector<float> latch_;
+};
+
+int main() {
+    constexpr size_t kBatchSize = 256;
+    constexpr size_t kNumSamples = 48000;
+    std::mt19937 rng{42};
+    std::uniform_real_distribution<float> dist{-1.0f, 1.0f};
+    std::vector<float> audio(kNumSamples);
+    for (auto& s : audio) {
+        s = dist(rng);
+    }
+    std::vector<float> work(kNumSamples);
+
+    // Msps: 每秒处理的百万采样数，GFLOPS按每个抽头一次乘加两个flop计算
+    std::printf("%-8s %8s %10s %10s %10s %10s %8s\n", "taps", "block", "scalar", "simd", "scalar", "simd", "speedup");
+    std::printf("%-8s %8s %10s %10s %10s %10s %8s\n", "", "", "Msps", "Msps", "GFLOPS", "GFLOPS", "");
+    for (size_t num_taps : {16, 32, 64, 128, 256, 512, 1024}) {
+        std::vector<float> coeff(num_taps);
+        for (auto& c : coeff) {
+            c = dist(rng) / static_cast<float>(num_taps);
+        }
+
+        ScalarFIR<kBatchSize> scalar;
+        scalar.SetCoeff(coeff);
+        qwqdsp::filter::FIRDirect<kBatchSize> simd;
+        simd.SetCoeff([&](std::vector<float>& c) {
+            c = coeff;
+        });
+        simd.Reset();
+
+        constexpr size_t kBlockSize = 128;
+        const double scalar_ns = qwqdsp::benchmark::MeasureNs([&] {
+            // 每次都从原始的输入开始，反复滤波会衰减到非规格化数
+            std::copy(audio.begin(), audio.end(), work.begin());
+            for (size_t i = 0; i < work.size(); i += kBlockSize) {
+                scalar.Process(std::span<float>{work.data() + i, kBlockSize});
+            }
+            qwqdsp::benchmark::DoNotOptimize(work[1]);
+        });
+        const double simd_ns = qwqdsp::benchmark::MeasureNs([&] {
+            // 每次都从原始的输入开始，反复滤波会衰减到非规格化数
+            std::copy(audio.begin(), audio.end(), work.begin());
+            for (size_t i = 0; i < work.size(); i += kBlockSize) {
+                simd.Process(std::span<float>{work.data() + i, kBlockSize});
+            }
+            qwqdsp::benchmark::DoNotOptimize(work[1]);
+        });
+        const double samples = static_cast<double>(kNumSamples);
+        const double flops = samples * static_cast<double>(num_taps) * 2.0;
+        std::printf("%-8zu %8zu %10.1f %10.1f %10.2f %10.2f %8.2f\n",
+            num_taps, kBlockSize,
+            samples * 1e3 / scalar_ns, samples * 1e3 / simd_ns,
+            flops / scalar_ns, flops / simd_ns,
+            scalar_ns / simd_ns);
+    }
+
+    // FIR根据抽头数和block大小在直接型和FFT之间选择
+    std::printf("\n%-8s %8s %10s %10s %8s\n", "taps", "block", "direct", "FIR", "path");
+    std::printf("%-8s %8s %10s %10s %8s\n", "", "", "Msps", "Msps", "");
+    for (size_t block_size : {64, 512}) {
+        for (size_t num_taps : {32, 128, 512, 2048}) {
+            std::vector<float> coeff(num_taps);
+            for (auto& c : coeff) {
+                c = dist(rng) / static_cast<float>(num_taps);
+            }
+            auto set_coeff = [&](std::vector<float>& c) {
+                c = coeff;
+            };
+
+            qwqdsp::filter::FIRDirect<kBatchSize> direct;
+            direct.SetCoeff(set_coeff);
+            direct.Reset();
+            qwqdsp::filter::FIR fir;
+            fir.Init(block_size);
+            fir.SetCoeff(set_coeff);
+            fir.Reset();
+
+            auto measure = [&](auto& filter) {
+                return qwqdsp::benchmark::MeasureNs([&] {
+                    std::copy(audio.begin(), audio.end(), work.begin());
+                    for (size_t i = 0; i < work.size(); i += block_size) {
+                        filter.Process(std::span<float>{work.data() + i, std::min(block_size, work.size() - i)});
+                    }
+                    qwqdsp::benchmark::DoNotOptimize(work[1]);
+                });
+            };
+            const double direct_ns = measure(direct);
+            const double fir_ns = measure(fir);
+            const double samples = static_cast<double>(kNumSamples);
+            std::printf("%-8zu %8zu %10.1f %10.1f %8s\n",
+                num_taps, block_size,
+                samples * 1e3 / direct_ns, samples * 1e3 / fir_ns,
+                fir.IsUsingFFT() ? "fft" : "direct");
+        }
+    }
+
+    // 对称系数折叠和同样长度的一般系数对比，改掉最后一个抽头让它不对称
+    std::printf("\n%-12s %8s %10s %10s %8s\n", "linear", "taps", "generic", "folded", "speedup");
+    std::printf("%-12s %8s %10s %10s %8s\n", "", "", "Msps", "Msps", "");
+    for (size_t num_taps : {63, 255, 1023}) {
+        std::vector<float> coeff(num_taps);
+        qwqdsp::filter::WindowFIR::Lowpass(coeff, 0.3f);
+        std::vector<float> asymmetric = coeff;
+        asymmetric.back() += 0.01f;
+        const double samples = static_cast<double>(kNumSamples);
+
+        auto measure = [&](auto& filter) {
+            return qwqdsp::benchmark::MeasureNs([&] {
+                filter.Process(audio, work);
+                qwqdsp::benchmark::DoNotOptimize(work[1]);
+            });
+        };
+        qwqdsp::filter::FIRDirect<kBatchSize> generic;
+        generic.SetCoeff([&](std::vector<float>& c) { c = asymmetric; });
+        generic.Reset();
+        qwqdsp::filter::FIRDirect<kBatchSize> folded;
+        folded.SetCoeff([&](std::vector<float>& c) { c = coeff; });
+        folded.Reset();
+        const double generic_ns = measure(generic);
+        const double folded_ns = measure(folded);
+        std::printf("%-12s %8zu %10.1f %10.1f %8.2f\n", "direct", num_taps,
+            samples * 1e3 / generic_ns, samples * 1e3 / folded_ns, generic_ns / folded_ns);
+    }
+
+    // 多相抽取/插值和全速率FIRDirect对比，全速率的抽取丢掉M-1个输出，插值先补0再滤波
+    std::printf("\n%-12s %8s %8s %10s %10s %8s\n", "multirate", "factor", "taps", "full", "polyphase", "speedup");
+    std::printf("%-12s %8s %8s %10s %10s %8s\n", "", "", "", "Msps", "Msps", "");
+    {
+        constexpr size_t kFactor = 4;
+        constexpr size_t kNumTaps = 128;
+        constexpr size_t kBlockSize = 240;
+        std::vector<float> coeff(kNumTaps);
+        for (auto& c : coeff) {
+            c = dist(rng) / static_cast<float>(kNumTaps);
+        }
+        auto set_coeff = [&](std::vector<float>& c) {
+            c = coeff;
+        };
+        const double samples = static_cast<double>(kNumSamples);
+
+        qwqdsp::filter::FIRDirect<kBatchSize> full;
+        full.SetCoeff(set_coeff);
+        full.Reset();
+        std::vector<float> decimated(kNumSamples / kFactor);
+        const double full_decimate_ns = qwqdsp::benchmark::MeasureNs([&] {
+            for (size_t i = 0; i < audio.size(); i += kBlockSize) {
+                full.Process(std::span<const float>{audio.data() + i, kBlockSize}, std::span<float>{work.data() + i, kBlockSize});
+                for (size_t j = 0; j < kBlockSize / kFactor; ++j) {
+                    decimated[i / kFactor + j] = work[i + j * kFactor];
+                }
+            }
+            qwqdsp::benchmark::DoNotOptimize(decimated[1]);
+        });
+        qwqdsp::filter::PolyphaseDecimator<kFactor> decimator;
+        decimator.SetCoeff(set_coeff);
+        const double decimate_ns = qwqdsp::benchmark::MeasureNs([&] {
+            for (size_t i = 0; i < audio.size(); i += kBlockSize) {
+                decimator.Process(std::span<const float>{audio.data() + i, kBlockSize}, std::span<float>{decimated.data() + i / kFactor, kBlockSize / kFactor});
+            }
+            qwqdsp::benchmark::DoNotOptimize(decimated[1]);
+        });
+        std::printf("%-12s %8zu %8zu %10.1f %10.1f %8.2f\n", "decimate", kFactor, kNumTaps,
+            samples * 1e3 / full_decimate_ns, samples * 1e3 / decimate_ns, full_decimate_ns / decimate_ns);
+
+        // 输入是kNumSamples / kFactor个，输出kNumSamples个，按输出计算速度
+        std::vector<float> stuffed(kBlockSize * kFactor);
+        const double full_interpolate_ns = qwqdsp::benchmark::MeasureNs([&] {
+            for (size_t i = 0; i < audio.size() / kFactor; i += kBlockSize) {
+                for (size_t j = 0; j < kBlockSize; ++j) {
+                    stuffed[j * kFactor] = audio[i + j];
+                    std::fill_n(stuffed.begin() + static_cast<std::ptrdiff_t>(j * kFactor + 1), kFactor - 1, 0.0f);
+                }
+                full.Process(stuffed, std::span<float>{work.data() + i * kFactor, kBlockSize * kFactor});
+            }
+            qwqdsp::benchmark::DoNotOptimize(work[1]);
+        });
+        qwqdsp::filter::PolyphaseInterpolator<kFactor> interpolator;
+        interpolator.SetCoeff(set_coeff);
+        const double interpolate_ns = qwqdsp::benchmark::MeasureNs([&] {
+            for (size_t i = 0; i < audio.size() / kFactor; i += kBlockSize) {
+                interpolator.Process(std::span<const float>{audio.data() + i, kBlockSize}, std::span<float>{work.data() + i * kFactor, kBlockSize * kFactor});
+            }
+            qwqdsp::benchmark::DoNotOptimize(work[1]);
+        });
+        std::printf("%-12s %8zu %8zu %10.1f %10.1f %8.2f\n", "interpolate", kFactor, kNumTaps,
+            samples * 1e3 / full_interpolate_ns, samples * 1e3 / interpolate_ns, full_interpolate_ns / interpolate_ns);
+    }
+
+    // 半带和通用FIR对比，同样的系数，跳过为0的抽头并且对称折叠
+    std::printf("\n%-12s %8s %10s %10s %8s\n", "halfband", "taps", "generic", "halfband", "speedup");
+    std::printf("%-12s %8s %10s %10s %8s\n", "", "", "Msps", "Msps", "");
+    for (size_t num_taps : {31, 63, 127}) {
+        constexpr size_t kBlockSize = 240;
+        std::vector<float> coeff(num_taps);
+        qwqdsp::filter::HalfbandDesign::Lowpass(coeff);
+        auto set_coeff = [&](std::vector<float>& c) {
+            c = coeff;
+        };
+        const double samples = static_cast<double>(kNumSamples);
+
+        qwqdsp::filter::FIRDirect<kBatchSize> generic;
+        generic.SetCoeff(set_coeff);
+        generic.Reset();
+        const double generic_ns = qwqdsp::benchmark::MeasureNs([&] {
+            generic.Process(audio, work);
+            qwqdsp::benchmark::DoNotOptimize(work[1]);
+        });
+        qwqdsp::filter::HalfbandFIR<kBatchSize> halfband;
+        halfband.SetCoeff(set_coeff);
+        const double halfband_ns = qwqdsp::benchmark::MeasureNs([&] {
+            halfband.Process(audio, work);
+            qwqdsp::benchmark::DoNotOptimize(work[1]);
+        });
+        std::printf("%-12s %8zu %10.1f %10.1f %8.2f\n", "full", num_taps,
+            samples * 1e3 / generic_ns, samples * 1e3 / halfband_ns, generic_ns / halfband_ns);
+
+        std::vector<float> decimated(kNumSamples / 2);
+        qwqdsp::filter::PolyphaseDecimator<2> polyphase;
+        polyphase.SetCoeff(set_coeff);
+        const double polyphase_ns = qwqdsp::benchmark::MeasureNs([&] {
+            for (size_t i = 0; i < audio.size(); i += kBlockSize) {
+                polyphase.Process(std::span<const float>{audio.data() + i, kBlockSize}, std::span<float>{decimated.data() + i / 2, kBlockSize / 2});
+            }
+            qwqdsp::benchmark::DoNotOptimize(decimated[1]);
+        });
+        qwqdsp::filter::HalfbandDecimator<kBatchSize> decimator;
+        decimator.SetCoeff(set_coeff);
+        const double decimate_ns = qwqdsp::benchmark::MeasureNs([&] {
+            for (size_t i = 0; i < audio.size(); i += kBlockSize) {
+                decimator.Process(std::span<const float>{audio.data() + i, kBlockSize}, std::span<float>{decimated.data() + i / 2, kBlockSize / 2});
+            }
+            qwqdsp::benchmark::DoNotOptimize(decimated[1]);
+        });
+        std::printf("%-12s %8zu %10.1f %10.1f %8.2f\n", "decimate", num_taps,
+            samples * 1e3 / polyphase_ns, samples * 1e3 / decimate_ns, polyphase_ns / decimate_ns);
+    }
+}
\ No newline at end of file
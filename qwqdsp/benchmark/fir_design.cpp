@@ -0,0 +1,89 @@
+#include <cmath>
+#include <complex>
+#include <cstddef>
+#include <cstdio>
+#include <numbers>
+#include <span>
+#include <vector>
+
+#include "bench.hpp"
+#include "qwqdsp/filter/fir_design.hpp"
+#include "qwqdsp/filter/window_fir.hpp"
+#include "qwqdsp/window/kaiser.hpp"
+
+namespace {
+constexpr float kPi = std::numbers::pi_v<float>;
+
+/**
+ * @brief [begin, end]上幅度响应的最大值，dB
+ */
+double PeakGainDb(std::span<const float> h, double begin, double end) {
+    constexpr size_t kNumPoints = 1024;
+    double peak = 0.0;
+    for (size_t i = 0; i <= kNumPoints; ++i) {
+        const double w = begin + (end - begin) * static_cast<double>(i) / kNumPoints;
+        std::complex<double> sum = 0.0;
+        for (size_t n = 0; n < h.size(); ++n) {
+            sum += static_cast<double>(h[n]) * std::polar(1.0, -w * static_cast<double>(n));
+        }
+        peak = std::max(peak, std::abs(sum));
+    }
+    return 20.0 * std::log10(peak);
+}
+
+/**
+ * @brief 满足阻带衰减的最短奇数长度
+ */
+template<class Design>
+size_t MinTaps(float stop, float atten, Design&& design) {
+    for (size_t n = 5; n < 2001; n += 2) {
+        std::vector<float> h(n);
+        design(h);
+        if (PeakGainDb(h, stop, kPi) <= -atten) {
+            return n;
+        }
+    }
+    return 0;
+}
+}
+
+int main() {
+    // 低通，通带到0.2pi，阻带从0.25pi开始
+    constexpr float kPass = 0.2f * kPi;
+    constexpr float kStop = 0.25f * kPi;
+    constexpr float kCutoff = (kPass + kStop) / 2;
+    constexpr float kWidth = kStop - kPass;
+
+    std::printf("%-14s %8s %10s\n", "design", "atten", "taps");
+    for (float atten : {40.0f, 60.0f, 80.0f}) {
+        const size_t kaiser = MinTaps(kStop, atten, [&](std::span<float> h) {
+            qwqdsp::filter::WindowFIR::Lowpass(h, kCutoff);
+            qwqdsp::window::Kaiser::ApplyWindow(h, qwqdsp::window::Kaiser::Beta(atten), false);
+            qwqdsp::filter::WindowFIR::Normalize(h);
+        });
+        const size_t least_square = MinTaps(kStop, atten, [&](std::span<float> h) {
+            qwqdsp::filter::FirDesign::LowpassLeastSquare(h, kCutoff, kWidth, 100.0f);
+        });
+        const size_t remez = MinTaps(kStop, atten, [&](std::span<float> h) {
+            qwqdsp::filter::FirDesign::LowpassRemez(h, kCutoff, kWidth, 10.0f);
+        });
+        std::printf("%-14s %8.0f %10zu\n", "kaiser", atten, kaiser);
+        std::printf("%-14s %8.0f %10zu\n", "least square", atten, least_square);
+        std::printf("%-14s %8.0f %10zu\n", "remez", atten, remez);
+    }
+
+    std::printf("\n%-14s %8s %10s\n", "design", "taps", "ms");
+    for (size_t num_taps : {63, 255, 1023}) {
+        std::vector<float> h(num_taps);
+        const double least_square_ns = qwqdsp::benchmark::MeasureNs([&] {
+            qwqdsp::filter::FirDesign::LowpassLeastSquare(h, kCutoff, kWidth, 100.0f);
+            qwqdsp::benchmark::DoNotOptimize(h[0]);
+        });
+        const double remez_ns = qwqdsp::benchmark::MeasureNs([&] {
+            qwqdsp::filter::FirDesign::LowpassRemez(h, kCutoff, kWidth, 10.0f);
+            qwqdsp::benchmark::DoNotOptimize(h[0]);
+        });
+        std::printf("%-14s %8zu %10.2f\n", "least square", num_taps, least_square_ns * 1e-6);
+        std::printf("%-14s %8zu %10.2f\n", "remez", num_taps, remez_ns * 1e-6);
+    }
+}
\ No newline at end of file
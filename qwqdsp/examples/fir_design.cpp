@@ -14,7 +14,7 @@ int main() {
     float pading[1024];
     std::complex<float> spectral[513];
     qwqdsp::window::Helper::ZeroPad(pading, test);
-    qwqdsp::spectral::RealFFT fft;
+    qwqdsp::spectral::RealFFT<> fft;
     fft.Init(1024);
     fft.FFT(pading, spectral);
 
@@ -46,7 +46,7 @@ int main() {
     float fir_pad2[1024];
     qwqdsp::window::Helper::ZeroPad(fir_pad2, fir);
     qwqdsp::window::Helper::ZeroPad(min_phase_pad, slice);
-    qwqdsp::spectral::RealFFT fft2;
+    qwqdsp::spectral::RealFFT<> fft2;
     constexpr size_t num_bins2 = fft2.NumBins(1024);
     float fir_gains[num_bins2];
     float min_phase_gains[num_bins2];
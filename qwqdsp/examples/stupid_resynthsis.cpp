@@ -18,7 +18,7 @@
 #include "qwqdsp/osciilor/table_sine_osc.hpp"
 
 static constexpr size_t kFFTSize = 512;
-static constexpr size_t kNumData = qwqdsp::spectral::RealFFT::NumBins(kFFTSize);
+static constexpr size_t kNumData = qwqdsp::spectral::RealFFT<>::NumBins(kFFTSize);
 struct Frame {
     std::array<float, kNumData> gains;
     std::array<float, kNumData> gain_dbs;
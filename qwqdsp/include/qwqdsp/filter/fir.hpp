@@ -1,13 +1,53 @@
 #pragma once
 #include <algorithm>
+#include <cassert>
+#include <cmath>
 #include <cstddef>
 #include <span>
 #include <vector>
+#include "qwqdsp/filter/internal/simd_fir.hpp"
 #include "qwqdsp/segement/slice.hpp"
+#include "qwqdsp/spectral/real_fft.hpp"
 
 namespace qwqdsp::filter {
+namespace internal {
 /**
- * @tparam kBatchSize 最大一次性处理多少采样，每隔这个数量才会执行一次移动采样，越大平均移动越少，同时内存增加
+ * @brief 系数严格对称时取出前一半(奇数长度包括中心)
+ *        只接受完全相等，不然折叠会悄悄改掉一个非对称的滤波器
+ * @return 是否对称
+ */
+inline bool FoldSymmetric(std::span<const float> coeff, std::vector<float>& half) {
+    const size_t n = coeff.size();
+    if (n < 2) {
+        return false;
+    }
+    for (size_t j = 0; j < n / 2; ++j) {
+        if (coeff[j] != coeff[n - 1 - j]) {
+            return false;
+        }
+    }
+    half.assign(coeff.begin(), coeff.begin() + static_cast<std::ptrdiff_t>((n + 1) / 2));
+    return true;
+}
+
+/**
+ * @brief 对称位置取平均，变成严格对称
+ */
+inline void Symmetrize(std::span<float> coeff) noexcept {
+    const size_t n = coeff.size();
+    for (size_t j = 0; j < n / 2; ++j) {
+        const float avg = (coeff[j] + coeff[n - 1 - j]) * 0.5f;
+        coeff[j] = avg;
+        coeff[n - 1 - j] = avg;
+    }
+}
+}
+
+/**
+ * @tparam kBatchSize 最大一次性处理多少采样，越大每次调用内核的开销越小，同时内存增加
+ *         历史采样存在镜像的环形缓冲里，写入时写两份，不需要移动采样
+ *         系数严格对称(线性相位)时自动折叠，对称位置的输入先相加，乘法减半
+ *         窗函数设计的系数两边可能差一个舍入误差，这时需要SetCoeff的symmetrize = true才会折叠
  */
 template <size_t kBatchSize>
 class FIRDirect {
@@ -19,68 +59,73 @@ public:
     /**
      * @brief 滤波器的参数是h(0)...h(n-1)排列，且coeff的大小需要手动分配
      * @tparam Func void(std::vector<float>& coeff)
+     * @param symmetrize true: 调用者保证设计是线性相位的，对称位置取平均后折叠
      */
     template <class Func>
-    void SetCoeff(Func&& func) {
+    void SetCoeff(Func&& func, bool symmetrize = false) {
         func(coeff_);
+        if (symmetrize) {
+            internal::Symmetrize(coeff_);
+        }
+        linear_phase_ = internal::FoldSymmetric(coeff_, half_coeff_);
         std::reverse(coeff_.begin(), coeff_.end());
-        size_t const size = coeff_.size() + kBatchSize - 1;
-        size_t const old_size = latch_.size();
-        if (old_size < size) {
-            latch_.resize(size);
-            for (size_t i = 0; i < old_size; ++i) {
-                size_t const target = size - i - 1;
-                size_t const source = old_size - i - 1;
-                latch_[target] = latch_[source];
-            }
-            std::fill_n(latch_.begin(), size - old_size, 0.0f);
+        size_t const capacity = coeff_.size() + kBatchSize - 1;
+        if (capacity_ < capacity) {
+            // 保留最近的历史采样，最新的放在末尾
+            std::vector<float> latch(capacity * 2);
+            std::copy_n(latch_.begin() + static_cast<std::ptrdiff_t>(wpos_), capacity_, latch.begin() + static_cast<std::ptrdiff_t>(capacity - capacity_));
+            std::copy_n(latch.begin(), capacity, latch.begin() + static_cast<std::ptrdiff_t>(capacity));
+            latch_.swap(latch);
+            capacity_ = capacity;
+            wpos_ = 0;
         }
     }
 
     void Process(std::span<float> x) noexcept {
-        segement::Slice1D slice{x};
-        size_t wpos = 0;
-        while (!slice.IsEnd()) {
-            // 首先向左移动缓冲区m个采样，复制m个采样到末尾，然后移动系数相加
-            auto block = slice.GetSome(kBatchSize);
-            for (size_t i = 0; i < latch_.size() - block.size(); ++i) {
-                latch_[i] = latch_[i + block.size()];
-            }
-            std::copy(block.begin(), block.end(), latch_.end() - block.size());
-
-            for (size_t i = 0; i < block.size(); ++i) {
-                float sum = 0.0f;
-                for (size_t j = 0; j < coeff_.size(); ++j) {
-                    sum += coeff_[j] * latch_[i + j];
-                }
-                x[wpos++] = sum;
-            }
-        }
+        Process(x, x);
     }
 
-    void Process(std::span<float> in, std::span<float> out) noexcept {
+    /**
+     * @param out 可以和in是同一块内存
+     */
+    void Process(std::span<const float> in, std::span<float> out) noexcept {
         segement::Slice1D slice{in};
         size_t wpos = 0;
         while (!slice.IsEnd()) {
-            // 首先向左移动缓冲区m个采样，复制m个采样到末尾，然后移动系数相加
             auto block = slice.GetSome(kBatchSize);
-            for (size_t i = 0; i < latch_.size() - block.size(); ++i) {
-                latch_[i] = latch_[i + block.size()];
+            for (float s : block) {
+                latch_[wpos_] = s;
+                latch_[wpos_ + capacity_] = s;
+                ++wpos_;
+                if (wpos_ >= capacity_) {
+                    wpos_ = 0;
+                }
             }
-            std::copy(block.begin(), block.end(), latch_.end() - block.size());
 
-            for (size_t i = 0; i < block.size(); ++i) {
-                float sum = 0.0f;
-                for (size_t j = 0; j < coeff_.size(); ++j) {
-                    sum += coeff_[j] * latch_[i + j];
-                }
-                out[wpos++] = sum;
+            // 最近的capacity_个采样从latch_[wpos_]开始连续存放
+            const float* history = latch_.data() + wpos_ + capacity_ - block.size() - coeff_.size() + 1;
+            if (linear_phase_) {
+                internal::simd_fir_symmetric(coeff_.size(), 1, block.size(), half_coeff_.data(), history, out.data() + wpos);
+            }
+            else {
+                internal::simd_fir(coeff_.size(), block.size(), coeff_.data(), history, out.data() + wpos);
             }
+            wpos += block.size();
         }
     }
+
+    bool IsLinearPhase() const noexcept {
+        return linear_phase_;
+    }
 private:
     std::vector<float> coeff_;
+    // 对称系数的前一半
+    std::vector<float> half_coeff_;
+    bool linear_phase_{};
+    // 镜像的环形缓冲，长度2 * capacity_
     std::vector<float> latch_;
+    size_t capacity_{};
+    size_t wpos_{};
 };
 
 class FIRTranspose {
@@ -124,4 +169,190 @@ private:
     std::vector<float> coeff_;
     std::vector<float> latch_;
 };
+
+/**
+ * @brief 根据抽头数和block大小自动在直接型和FFT overlap-save之间选择的FIR，没有延迟
+ *        两种方式共用同一份历史采样，抽头数不超过Init的max_num_taps时SetCoeff切换方式输出是连续的
+ *        超过时历史缓冲会变大，只保留原来的采样，更早的当作0，之后抽头数个输出和完整的卷积不一致
+ *        FFT方式每个block做一次N >= 抽头数 + block - 1点的FFT，IR远长于block时请用fx::PartitionedConvolution
+ *        FFT大小按Init的max_block_size选，实际的block短到直接型更便宜时这个block改用直接型，输出同样是连续的
+ */
+class FIR {
+public:
+    /**
+     * @brief 之后没有SetCoeff也可以Process，系数是1个抽头的1，输出等于输入
+     * @param max_block_size 每次最多处理多少采样，Process更长的输入时会分段
+     * @param max_num_taps 预先分配这么长的历史，之后SetCoeff不超过它的时候输出是连续的
+     */
+    void Init(size_t max_block_size, size_t max_num_taps = 0) {
+        assert(max_block_size > 0);
+        block_size_ = max_block_size;
+        coeff_.assign(1, 1.0f);
+        capacity_ = 0;
+        latch_.clear();
+        wpos_ = 0;
+        use_fft_ = false;
+        linear_phase_ = false;
+        ReserveHistory(std::max<size_t>(max_num_taps, 1) + block_size_ - 1);
+    }
+
+    /**
+     * @brief 直接型每个输出需要num_taps次乘加，FFT方式每个block需要正反两次FFT和一次频谱乘法
+     *        两种内核的速度差由kFFTCostRatio校准，见benchmark/fir.cpp
+     */
+    static bool PreferFFT(size_t num_taps, size_t block_size) noexcept {
+        const double direct_cost = static_cast<double>(num_taps) * static_cast<double>(block_size);
+        return FFTCost(FFTSize(num_taps, block_size)) < direct_cost;
+    }
+
+    /**
+     * @brief 滤波器的参数是h(0)...h(n-1)排列，且coeff的大小需要手动分配
+     * @tparam Func void(std::vector<float>& coeff)
+     * @param symmetrize true: 调用者保证设计是线性相位的，对称位置取平均后折叠
+     */
+    template <class Func>
+    void SetCoeff(Func&& func, bool symmetrize = false) {
+        func(coeff_);
+        assert(!coeff_.empty());
+        const size_t num_taps = coeff_.size();
+        if (symmetrize) {
+            internal::Symmetrize(coeff_);
+        }
+        linear_phase_ = internal::FoldSymmetric(coeff_, half_coeff_);
+        use_fft_ = PreferFFT(num_taps, block_size_);
+        ReserveHistory(num_taps + block_size_ - 1);
+        if (use_fft_) {
+            const size_t fft_size = FFTSize(num_taps, block_size_);
+            fft_.Init(fft_size, spectral::FFTBackend::kSimd);
+            fft_buffer_.resize(fft_size);
+            spectrum_.Resize(fft_.NumBins());
+            coeff_spectrum_.Resize(fft_.NumBins());
+            std::fill(fft_buffer_.begin(), fft_buffer_.end(), 0.0f);
+            std::copy(coeff_.begin(), coeff_.end(), fft_buffer_.begin());
+            fft_.FFT(fft_buffer_, coeff_spectrum_);
+            // 不管block多短都要做同样大小的FFT，估计直接型便宜一半以上的短block改用直接型
+            // 短block的直接型内核填不满4个向量的tile，实测要留这么多余量
+            fft_min_block_ = static_cast<size_t>(FFTCost(fft_size) / (kShortBlockMargin * static_cast<double>(num_taps))) + 1;
+        }
+        // 直接型是FFT方式处理短block的后备，总是准备好
+        std::reverse(coeff_.begin(), coeff_.end());
+    }
+
+    void Reset() noexcept {
+        std::fill(latch_.begin(), latch_.end(), 0.0f);
+    }
+
+    void Process(std::span<float> x) noexcept {
+        Process(x, x);
+    }
+
+    /**
+     * @brief 需要先Init
+     * @param out 可以和in是同一块内存
+     */
+    void Process(std::span<const float> in, std::span<float> out) noexcept {
+        assert(!coeff_.empty());
+        segement::Slice1D slice{in};
+        size_t wpos = 0;
+        while (!slice.IsEnd()) {
+            auto block = slice.GetSome(block_size_);
+            for (float s : block) {
+                latch_[wpos_] = s;
+                latch_[wpos_ + capacity_] = s;
+                ++wpos_;
+                if (wpos_ >= capacity_) {
+                    wpos_ = 0;
+                }
+            }
+
+            // 最近的capacity_个采样从latch_[wpos_]开始连续存放
+            const size_t num_taps = coeff_.size();
+            const float* history = latch_.data() + wpos_ + capacity_ - block.size() - num_taps + 1;
+            if (use_fft_ && block.size() >= fft_min_block_) {
+                // 循环卷积的前num_taps-1个输出有混叠，后面的block.size()个就是线性卷积
+                const size_t num_history = num_taps - 1 + block.size();
+                std::copy_n(history, num_history, fft_buffer_.begin());
+                std::fill(fft_buffer_.begin() + static_cast<std::ptrdiff_t>(num_history), fft_buffer_.end(), 0.0f);
+                fft_.FFT(fft_buffer_, spectrum_);
+                spectrum_.Multiply(spectrum_, coeff_spectrum_);
+                fft_.IFFT(fft_buffer_, spectrum_);
+                std::copy_n(fft_buffer_.begin() + static_cast<std::ptrdiff_t>(num_taps - 1), block.size(), out.begin() + static_cast<std::ptrdiff_t>(wpos));
+            }
+            else if (linear_phase_) {
+                internal::simd_fir_symmetric(num_taps, 1, block.size(), half_coeff_.data(), history, out.data() + wpos);
+            }
+            else {
+                internal::simd_fir(num_taps, block.size(), coeff_.data(), history, out.data() + wpos);
+            }
+            wpos += block.size();
+        }
+    }
+
+    /**
+     * @brief 满长的block是否用FFT，短的block仍然可能走直接型
+     */
+    bool IsUsingFFT() const noexcept {
+        return use_fft_;
+    }
+
+    bool IsLinearPhase() const noexcept {
+        return linear_phase_;
+    }
+
+    size_t GetBlockSize() const noexcept {
+        return block_size_;
+    }
+private:
+    // FFT每个点的开销相当于直接型多少次乘加，SSE上实测约4，AVX2+FMA上约6
+    static constexpr double kFFTCostRatio = 5.0;
+    // 短block改用直接型时估计的开销至少要便宜这么多倍
+    static constexpr double kShortBlockMargin = 2.0;
+
+    static double FFTCost(size_t fft_size) noexcept {
+        const double n = static_cast<double>(fft_size);
+        return kFFTCostRatio * n * (std::log2(n) + 1.0);
+    }
+
+    static size_t FFTSize(size_t num_taps, size_t block_size) noexcept {
+        size_t fft_size = 16;
+        while (fft_size < num_taps + block_size - 1) {
+            fft_size *= 2;
+        }
+        return fft_size;
+    }
+
+    /**
+     * @brief 保留最近的历史采样，最新的放在末尾
+     */
+    void ReserveHistory(size_t capacity) {
+        if (capacity_ >= capacity) {
+            return;
+        }
+        std::vector<float> latch(capacity * 2);
+        std::copy_n(latch_.begin() + static_cast<std::ptrdiff_t>(wpos_), capacity_, latch.begin() + static_cast<std::ptrdiff_t>(capacity - capacity_));
+        std::copy_n(latch.begin(), capacity, latch.begin() + static_cast<std::ptrdiff_t>(capacity));
+        latch_.swap(latch);
+        capacity_ = capacity;
+        wpos_ = 0;
+    }
+
+    size_t block_size_{};
+    bool use_fft_{};
+    // 比这短的block即使use_fft_也用直接型
+    size_t fft_min_block_{};
+    // 倒序，直接型用，FFT方式用coeff_spectrum_
+    std::vector<float> coeff_;
+    // 对称系数的前一半，直接型用
+    std::vector<float> half_coeff_;
+    bool linear_phase_{};
+    // 镜像的环形缓冲，长度2 * capacity_
+    std::vector<float> latch_;
+    size_t capacity_{};
+    size_t wpos_{};
+
+    spectral::RealFFT<> fft_;
+    std::vector<float> fft_buffer_;
+    spectral::SplitSpectrum<> spectrum_;
+    spectral::SplitSpectrum<> coeff_spectrum_;
+};
 }
\ No newline at end of file
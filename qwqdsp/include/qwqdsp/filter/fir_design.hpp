@@ -1,4 +1,5 @@
 #pragma once
+#include <cstddef>
 #include <span>
 
 namespace qwqdsp::filter {
@@ -14,6 +15,35 @@ struct FirDesign {
         float transist_width, float stop_band_weight
     );
 
+    /**
+     * @brief Parks-McClellan等波纹设计，对称系数，奇数和偶数长度都可以
+     *        偶数长度在pi处的响应必然为0，不能设计高通
+     * @param bands 频带边缘[0, pi]，每两个一组，递增
+     * @param desired 每个频带的幅度
+     * @param weights 每个频带误差的权重，越大这个频带的波纹越小
+     * @return 是否在max_iterations次交换之内收敛，没有收敛时是最大误差最小的那一次
+     *         阻带衰减超过约140dB时double的精度不够，通常不会收敛，误差停在float系数的精度附近
+     */
+    static bool Remez(
+        std::span<float> x,
+        std::span<const float> bands,
+        std::span<const float> desired,
+        std::span<const float> weights,
+        size_t max_iterations = 40
+    );
+
+    /**
+     * @brief 等波纹低通，参数和LowpassLeastSquare一样
+     * @param cutoff [0, pi]
+     * @param transist_width [0, pi]
+     * @param stop_band_weight 阻带波纹是通带的1/stop_band_weight
+     */
+    static bool LowpassRemez(
+        std::span<float> x,
+        float cutoff,
+        float transist_width, float stop_band_weight
+    );
+
     static void GainResponce(
         std::span<float> coeffs,
         std::span<float> gains
@@ -0,0 +1,320 @@
+#pragma once
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cmath>
+#include <cstddef>
+#include <numbers>
+#include <span>
+#include <vector>
+#include "qwqdsp/filter/internal/simd_fir.hpp"
+#include "qwqdsp/filter/window_fir.hpp"
+#include "qwqdsp/segement/slice.hpp"
+#include "qwqdsp/window/kaiser.hpp"
+
+namespace qwqdsp::filter {
+/**
+ * @brief 半带低通，长度N = 4K - 1，中心h[2K - 1] = 0.5，离中心偶数距离的系数都是0
+ *        非零的系数只有K对对称的h[2j] = h[N - 1 - 2j]和中心，每个输出只要K + 1次乘法
+ */
+struct HalfbandDesign {
+    /**
+     * @brief pi/2的Kaiser窗sinc，把应该为0的系数置为严格的0，直流增益为1
+     * @param x 长度为4K - 1
+     * @param atten (>0)dB 阻带衰减，决定Kaiser窗的beta
+     */
+    static void Lowpass(std::span<float> x, float atten = 80.0f) noexcept {
+        assert(x.size() % 4 == 3);
+        WindowFIR::Lowpass(x, std::numbers::pi_v<float> / 2.0f);
+        window::Kaiser::ApplyWindow(x, window::Kaiser::Beta(atten), false);
+        const size_t n = x.size();
+        const size_t center = n / 2;
+        float sum = 0.0f;
+        for (size_t i = 0; i < center; i += 2) {
+            sum += x[i];
+        }
+        // 偶数位置的和是0.5，奇数位置只剩下中心，后一半直接镜像保证严格对称
+        const float gain = 0.25f / sum;
+        for (size_t i = 0; i < center; ++i) {
+            x[i] = i % 2 == 0 ? x[i] * gain : 0.0f;
+            x[n - 1 - i] = x[i];
+        }
+        x[center] = 0.5f;
+    }
+
+    static bool IsHalfband(std::span<const float> x) noexcept {
+        if (x.size() % 4 != 3) {
+            return false;
+        }
+        const size_t n = x.size();
+        for (size_t i = 0; i < n; ++i) {
+            if (x[i] != x[n - 1 - i]) {
+                return false;
+            }
+            if (i % 2 == 1 && i != n / 2 && x[i] != 0.0f) {
+                return false;
+            }
+        }
+        return true;
+    }
+};
+
+namespace internal {
+/**
+ * @brief 从半带的系数中取出K对的一半h[0], h[2], ..., h[2K - 2]和中心
+ */
+inline float ExtractHalfbandPairs(std::span<const float> h, std::vector<float>& pairs, float gain) {
+    assert(HalfbandDesign::IsHalfband(h));
+    const size_t num_pairs = (h.size() + 1) / 4;
+    pairs.resize(num_pairs);
+    for (size_t j = 0; j < num_pairs; ++j) {
+        pairs[j] = h[2 * j] * gain;
+    }
+    return h[h.size() / 2] * gain;
+}
+}
+
+/**
+ * @brief 全速率的半带FIR，跳过为0的系数，对称的输入先相加，乘法从N次降到K + 1次
+ * @tparam kBatchSize 一次最多处理多少采样
+ */
+template<size_t kBatchSize = 64>
+class HalfbandFIR {
+public:
+    void Reset() noexcept {
+        std::fill(latch_.begin(), latch_.end(), 0.0f);
+        wpos_ = 0;
+    }
+
+    /**
+     * @brief 滤波器的参数是h(0)...h(n-1)排列，必须是半带的，见HalfbandDesign，会Reset
+     * @tparam Func void(std::vector<float>& coeff)
+     */
+    template <class Func>
+    void SetCoeff(Func&& func) {
+        func(coeff_);
+        center_ = internal::ExtractHalfbandPairs(coeff_, pairs_, 1.0f);
+        capacity_ = coeff_.size() + kBatchSize - 1;
+        latch_.resize(capacity_ * 2);
+        Reset();
+    }
+
+    void Process(std::span<float> x) noexcept {
+        Process(x, x);
+    }
+
+    /**
+     * @param out 可以和in是同一块内存
+     */
+    void Process(std::span<const float> in, std::span<float> out) noexcept {
+        segement::Slice1D slice{in};
+        size_t rpos = 0;
+        while (!slice.IsEnd()) {
+            auto block = slice.GetSome(kBatchSize);
+            for (float s : block) {
+                latch_[wpos_] = s;
+                latch_[wpos_ + capacity_] = s;
+                ++wpos_;
+                if (wpos_ >= capacity_) {
+                    wpos_ = 0;
+                }
+            }
+
+            const size_t num_pairs = pairs_.size();
+            const float* history = latch_.data() + wpos_ + capacity_ - block.size() - coeff_.size() + 1;
+            float* y = out.data() + rpos;
+            internal::simd_fir_symmetric(num_pairs * 2, 2, block.size(), pairs_.data(), history, y);
+            const float* delayed = history + num_pairs * 2 - 1;
+            for (size_t i = 0; i < block.size(); ++i) {
+                y[i] += center_ * delayed[i];
+            }
+            rpos += block.size();
+        }
+    }
+
+    /**
+     * @brief 群延迟，(N - 1) / 2
+     */
+    size_t GetDelay() const noexcept {
+        return coeff_.size() / 2;
+    }
+private:
+    std::vector<float> coeff_;
+    std::vector<float> pairs_;
+    float center_{};
+    // 镜像的环形缓冲，长度2 * capacity_
+    std::vector<float> latch_;
+    size_t capacity_{};
+    size_t wpos_{};
+};
+
+/**
+ * @brief 半带2倍抽取，y[m] = sum_n h[n] * x[2m - n]
+ *        偶数输入是2K抽头的对称FIR，奇数输入只有中心一个系数，相当于延迟
+ * @tparam kBatchSize 一次最多计算多少个输出
+ */
+template<size_t kBatchSize = 64>
+class HalfbandDecimator {
+public:
+    void Reset() noexcept {
+        std::fill(even_.begin(), even_.end(), 0.0f);
+        std::fill(odd_.begin(), odd_.end(), 0.0f);
+        even_wpos_ = 0;
+        odd_wpos_ = 0;
+        phase_ = 0;
+    }
+
+    /**
+     * @brief 滤波器的参数是h(0)...h(n-1)排列，必须是半带的，见HalfbandDesign，会Reset
+     * @tparam Func void(std::vector<float>& coeff)
+     */
+    template <class Func>
+    void SetCoeff(Func&& func) {
+        func(coeff_);
+        center_ = internal::ExtractHalfbandPairs(coeff_, pairs_, 1.0f);
+        even_capacity_ = pairs_.size() * 2 + kBatchSize - 1;
+        odd_capacity_ = pairs_.size() + kBatchSize;
+        even_.resize(even_capacity_ * 2);
+        odd_.resize(odd_capacity_ * 2);
+        Reset();
+    }
+
+    /**
+     * @param out 至少(in.size() + 1) / 2个
+     * @return 这次输出了多少个采样
+     */
+    size_t Process(std::span<const float> in, std::span<float> out) noexcept {
+        size_t num_output = 0;
+        size_t pos = 0;
+        while (pos < in.size()) {
+            // 每段在第num个偶数采样结束，这时刚好凑齐num个输出
+            const size_t remain = in.size() - pos;
+            const size_t first = phase_;
+            size_t num = 0;
+            size_t chunk = remain;
+            if (first < remain) {
+                num = std::min(kBatchSize, (remain - first - 1) / 2 + 1);
+                chunk = first + (num - 1) * 2 + 1;
+            }
+            for (size_t i = 0; i < chunk; ++i) {
+                const float s = in[pos + i];
+                if ((phase_ + i) % 2 == 0) {
+                    Push(even_, even_wpos_, even_capacity_, s);
+                }
+                else {
+                    Push(odd_, odd_wpos_, odd_capacity_, s);
+                }
+            }
+            phase_ = (phase_ + chunk) % 2;
+            pos += chunk;
+            if (num != 0) {
+                Flush(num, out.subspan(num_output, num));
+                num_output += num;
+            }
+        }
+        return num_output;
+    }
+private:
+    static void Push(std::vector<float>& latch, size_t& wpos, size_t capacity, float s) noexcept {
+        latch[wpos] = s;
+        latch[wpos + capacity] = s;
+        ++wpos;
+        if (wpos >= capacity) {
+            wpos = 0;
+        }
+    }
+
+    void Flush(size_t num, std::span<float> out) noexcept {
+        const size_t num_pairs = pairs_.size();
+        // 偶数: E[m - 2K + 1] ~ E[m]
+        const float* even = even_.data() + even_wpos_ + even_capacity_ - num - num_pairs * 2 + 1;
+        internal::simd_fir_symmetric(num_pairs * 2, 1, num, pairs_.data(), even, out.data());
+        // 奇数: O[m - K]，最新的是O[m - 1]
+        const float* odd = odd_.data() + odd_wpos_ + odd_capacity_ - num - num_pairs + 1;
+        for (size_t i = 0; i < num; ++i) {
+            out[i] += center_ * odd[i];
+        }
+    }
+
+    std::vector<float> coeff_;
+    std::vector<float> pairs_;
+    float center_{};
+    // 偶数和奇数输入各一个镜像的环形缓冲
+    std::vector<float> even_;
+    std::vector<float> odd_;
+    size_t even_capacity_{};
+    size_t odd_capacity_{};
+    size_t even_wpos_{};
+    size_t odd_wpos_{};
+    // 下一个输入采样的t mod 2
+    size_t phase_{};
+};
+
+/**
+ * @brief 半带2倍插值，输出已经乘以2，通带增益为1
+ *        偶数输出是2K抽头的对称FIR，奇数输出只有中心一个系数，相当于延迟
+ * @tparam kBatchSize 一次最多处理多少个输入
+ */
+template<size_t kBatchSize = 64>
+class HalfbandInterpolator {
+public:
+    void Reset() noexcept {
+        std::fill(latch_.begin(), latch_.end(), 0.0f);
+        wpos_ = 0;
+    }
+
+    /**
+     * @brief 滤波器的参数是h(0)...h(n-1)排列，必须是半带的，见HalfbandDesign，会Reset
+     * @tparam Func void(std::vector<float>& coeff)
+     */
+    template <class Func>
+    void SetCoeff(Func&& func) {
+        func(coeff_);
+        center_ = internal::ExtractHalfbandPairs(coeff_, pairs_, 2.0f);
+        capacity_ = pairs_.size() * 2 + kBatchSize - 1;
+        latch_.resize(capacity_ * 2);
+        Reset();
+    }
+
+    /**
+     * @param out in.size() * 2个，不能和in是同一块内存
+     */
+    void Process(std::span<const float> in, std::span<float> out) noexcept {
+        assert(out.size() == in.size() * 2);
+        segement::Slice1D slice{in};
+        size_t rpos = 0;
+        while (!slice.IsEnd()) {
+            auto block = slice.GetSome(kBatchSize);
+            for (float s : block) {
+                latch_[wpos_] = s;
+                latch_[wpos_ + capacity_] = s;
+                ++wpos_;
+                if (wpos_ >= capacity_) {
+                    wpos_ = 0;
+                }
+            }
+
+            // x[m - 2K + 1] ~ x[m]
+            const size_t num_pairs = pairs_.size();
+            const float* history = latch_.data() + wpos_ + capacity_ - block.size() - num_pairs * 2 + 1;
+            internal::simd_fir_symmetric(num_pairs * 2, 1, block.size(), pairs_.data(), history, temp_.data());
+            const float* delayed = history + num_pairs;
+            float* y = out.data() + rpos * 2;
+            for (size_t i = 0; i < block.size(); ++i) {
+                y[i * 2] = temp_[i];
+                y[i * 2 + 1] = center_ * delayed[i];
+            }
+            rpos += block.size();
+        }
+    }
+private:
+    std::vector<float> coeff_;
+    std::vector<float> pairs_;
+    float center_{};
+    // 镜像的环形缓冲，长度2 * capacity_
+    std::vector<float> latch_;
+    size_t capacity_{};
+    size_t wpos_{};
+    std::array<float, kBatchSize> temp_{};
+};
+}
\ No newline at end of file
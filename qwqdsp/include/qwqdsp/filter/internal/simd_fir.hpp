@@ -0,0 +1,34 @@
+#pragma once
+#include <cstddef>
+
+namespace qwqdsp::filter::internal {
+
+// --------------------------------------------------------------------------------
+// 直接型FIR
+//
+// 在输出方向向量化，一次算4个向量的输出，每个系数只广播一次
+// --------------------------------------------------------------------------------
+
+/**
+ * @brief output[i] = sum_{j=0}^{num_taps-1} coeff[j] * history[i + j]
+ * @param coeff 倒序的系数
+ * @param history num_outputs + num_taps - 1个采样
+ */
+void simd_fir(
+    size_t num_taps, size_t num_outputs,
+    const float* coeff, const float* history, float* output
+) noexcept;
+
+/**
+ * @brief 对称系数的FIR，先把对称位置的输入相加再乘，乘法减半
+ *        output[i] = sum_{j=0}^{num_taps-1} h[j] * history[i + j * step]，其中h[j] = h[num_taps - 1 - j]
+ * @param num_taps 对称的抽头数，可以是奇数
+ * @param step 抽头的间隔，半带滤波器为2
+ * @param coeff 前一半的系数h[0]...h[(num_taps + 1) / 2 - 1]，奇数长度的最后一个是中心
+ * @param history num_outputs + (num_taps - 1) * step个采样
+ */
+void simd_fir_symmetric(
+    size_t num_taps, size_t step, size_t num_outputs,
+    const float* coeff, const float* history, float* output
+) noexcept;
+}
\ No newline at end of file
@@ -0,0 +1,210 @@
+#pragma once
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cstddef>
+#include <span>
+#include <vector>
+#include "qwqdsp/filter/internal/simd_fir.hpp"
+#include "qwqdsp/segement/slice.hpp"
+
+namespace qwqdsp::filter {
+/**
+ * @brief 多相FIR抽取，y[m] = sum_n h[n] * x[m * M - n]，只计算保留下来的输出
+ *        第k个分支的系数为h[j * M + k]，输入为x[m * M - k]，每个分支的历史采样连续存放，可以用simd_fir一次算多个输出
+ * @tparam kFactor M
+ * @tparam kBatchSize 每个分支一次最多计算多少个输出
+ */
+template<size_t kFactor, size_t kBatchSize = 64>
+class PolyphaseDecimator {
+public:
+    static_assert(kFactor > 0);
+
+    void Reset() noexcept {
+        for (auto& l : latch_) {
+            std::fill(l.begin(), l.end(), 0.0f);
+        }
+        wpos_.fill(0);
+        phase_ = 0;
+    }
+
+    /**
+     * @brief 滤波器的参数是h(0)...h(n-1)排列，且coeff的大小需要手动分配，会Reset
+     * @tparam Func void(std::vector<float>& coeff)
+     */
+    template <class Func>
+    void SetCoeff(Func&& func) {
+        func(coeff_);
+        assert(!coeff_.empty());
+        branch_size_ = (coeff_.size() + kFactor - 1) / kFactor;
+        capacity_ = branch_size_ + kBatchSize - 1;
+        for (size_t k = 0; k < kFactor; ++k) {
+            auto& branch = branches_[k];
+            branch.assign(branch_size_, 0.0f);
+            for (size_t j = 0; j < branch_size_ && j * kFactor + k < coeff_.size(); ++j) {
+                branch[branch_size_ - 1 - j] = coeff_[j * kFactor + k];
+            }
+            latch_[k].resize(capacity_ * 2);
+        }
+        Reset();
+    }
+
+    /**
+     * @param out 至少(in.size() + kFactor - 1) / kFactor个
+     * @return 这次输出了多少个采样
+     */
+    size_t Process(std::span<const float> in, std::span<float> out) noexcept {
+        size_t num_output = 0;
+        size_t pos = 0;
+        while (pos < in.size()) {
+            // 每段在第num个k == 0的采样结束，这时所有分支刚好凑齐num个输出
+            const size_t remain = in.size() - pos;
+            const size_t first = phase_ == 0 ? 0 : kFactor - phase_;
+            size_t num = 0;
+            size_t chunk = remain;
+            if (first < remain) {
+                num = std::min(kBatchSize, (remain - first - 1) / kFactor + 1);
+                chunk = first + (num - 1) * kFactor + 1;
+            }
+            // x[t]属于第(-t mod M)个分支
+            for (size_t k = 0; k < kFactor; ++k) {
+                float* latch = latch_[k].data();
+                size_t wpos = wpos_[k];
+                const size_t begin = (kFactor * 2 - phase_ - k) % kFactor;
+                for (size_t i = begin; i < chunk; i += kFactor) {
+                    const float s = in[pos + i];
+                    latch[wpos] = s;
+                    latch[wpos + capacity_] = s;
+                    ++wpos;
+                    if (wpos >= capacity_) {
+                        wpos = 0;
+                    }
+                }
+                wpos_[k] = wpos;
+            }
+            phase_ = (phase_ + chunk) % kFactor;
+            pos += chunk;
+            if (num != 0) {
+                Flush(num, out.subspan(num_output, num));
+                num_output += num;
+            }
+        }
+        return num_output;
+    }
+
+    size_t GetFactor() const noexcept {
+        return kFactor;
+    }
+private:
+    void Flush(size_t num, std::span<float> out) noexcept {
+        for (size_t k = 0; k < kFactor; ++k) {
+            const float* history = latch_[k].data() + wpos_[k] + capacity_ - num - branch_size_ + 1;
+            if (k == 0) {
+                internal::simd_fir(branch_size_, num, branches_[k].data(), history, out.data());
+            }
+            else {
+                internal::simd_fir(branch_size_, num, branches_[k].data(), history, temp_.data());
+                for (size_t i = 0; i < num; ++i) {
+                    out[i] += temp_[i];
+                }
+            }
+        }
+    }
+
+    std::vector<float> coeff_;
+    size_t branch_size_{};
+    // 倒序的分支系数
+    std::array<std::vector<float>, kFactor> branches_;
+    // 每个分支一个镜像的环形缓冲，长度2 * capacity_
+    std::array<std::vector<float>, kFactor> latch_;
+    std::array<size_t, kFactor> wpos_{};
+    size_t capacity_{};
+    // 下一个输入采样的t mod M
+    size_t phase_{};
+    std::array<float, kBatchSize> temp_{};
+};
+
+/**
+ * @brief 多相FIR插值，y[t] = sum_n h[n] * u[t - n]，u是在x的采样之间插入L-1个0
+ *        第k个分支的系数为h[j * L + k]，计算输出y[m * L + k]，不需要对插入的0做乘法
+ *        通带增益为1需要系数之和为L
+ * @tparam kFactor L
+ * @tparam kBatchSize 每个分支一次最多计算多少个输出
+ */
+template<size_t kFactor, size_t kBatchSize = 64>
+class PolyphaseInterpolator {
+public:
+    static_assert(kFactor > 0);
+
+    void Reset() noexcept {
+        std::fill(latch_.begin(), latch_.end(), 0.0f);
+        wpos_ = 0;
+    }
+
+    /**
+     * @brief 滤波器的参数是h(0)...h(n-1)排列，且coeff的大小需要手动分配，会Reset
+     * @tparam Func void(std::vector<float>& coeff)
+     */
+    template <class Func>
+    void SetCoeff(Func&& func) {
+        func(coeff_);
+        assert(!coeff_.empty());
+        branch_size_ = (coeff_.size() + kFactor - 1) / kFactor;
+        capacity_ = branch_size_ + kBatchSize - 1;
+        for (size_t k = 0; k < kFactor; ++k) {
+            auto& branch = branches_[k];
+            branch.assign(branch_size_, 0.0f);
+            for (size_t j = 0; j < branch_size_ && j * kFactor + k < coeff_.size(); ++j) {
+                branch[branch_size_ - 1 - j] = coeff_[j * kFactor + k];
+            }
+        }
+        latch_.resize(capacity_ * 2);
+        Reset();
+    }
+
+    /**
+     * @param out in.size() * kFactor个，不能和in是同一块内存
+     */
+    void Process(std::span<const float> in, std::span<float> out) noexcept {
+        assert(out.size() == in.size() * kFactor);
+        segement::Slice1D slice{in};
+        size_t rpos = 0;
+        while (!slice.IsEnd()) {
+            auto block = slice.GetSome(kBatchSize);
+            for (float s : block) {
+                latch_[wpos_] = s;
+                latch_[wpos_ + capacity_] = s;
+                ++wpos_;
+                if (wpos_ >= capacity_) {
+                    wpos_ = 0;
+                }
+            }
+
+            // 所有分支共用输入的历史采样
+            const float* history = latch_.data() + wpos_ + capacity_ - block.size() - branch_size_ + 1;
+            float* y = out.data() + rpos * kFactor;
+            for (size_t k = 0; k < kFactor; ++k) {
+                internal::simd_fir(branch_size_, block.size(), branches_[k].data(), history, temp_.data());
+                for (size_t i = 0; i < block.size(); ++i) {
+                    y[i * kFactor + k] = temp_[i];
+                }
+            }
+            rpos += block.size();
+        }
+    }
+
+    size_t GetFactor() const noexcept {
+        return kFactor;
+    }
+private:
+    std::vector<float> coeff_;
+    size_t branch_size_{};
+    // 倒序的分支系数
+    std::array<std::vector<float>, kFactor> branches_;
+    // 镜像的环形缓冲，长度2 * capacity_
+    std::vector<float> latch_;
+    size_t capacity_{};
+    size_t wpos_{};
+    std::array<float, kBatchSize> temp_{};
+};
+}
\ No newline at end of file
@@ -0,0 +1,161 @@
+#pragma once
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <span>
+#include <vector>
+#include "qwqdsp/spectral/frequency_delay_line.hpp"
+#include "qwqdsp/spectral/real_fft.hpp"
+#include "qwqdsp/window/helper.hpp"
+
+namespace qwqdsp::fx {
+/**
+ * @brief M个输入 x N个输出的均匀分区卷积，out[n] = sum_m in[m] * ir[m][n]
+ *        每个输入只做一次FFT存进共享的频谱延迟线，每个输出只做一次IFFT，FFT次数从M*N降到M+N
+ *        用于true stereo混响(2x2)和多扬声器房间校正
+ *        overlap-save，延迟为latency，block大小任意
+ */
+class MatrixConvolution {
+public:
+    void Init(size_t num_inputs, size_t num_outputs, size_t latency) {
+        assert(num_inputs > 0 && num_outputs > 0 && latency > 0);
+        num_inputs_ = num_inputs;
+        num_outputs_ = num_outputs;
+        block_size_ = latency;
+        fft_.Init(latency * 2);
+        buffer_.resize(latency * 2);
+        output_frame_.Resize(fft_.NumBins());
+        input_buffers_.resize(num_inputs);
+        for (auto& b : input_buffers_) {
+            b.resize(latency * 2);
+        }
+        output_buffers_.resize(num_outputs);
+        for (auto& b : output_buffers_) {
+            b.resize(latency);
+        }
+        ir_frames_.clear();
+        ir_frames_.resize(num_inputs * num_outputs);
+        input_frames_.resize(num_inputs);
+        ResizeDelayLine(1);
+        Reset();
+    }
+
+    /**
+     * @brief 设置输入input到输出output的IR，空的IR表示这条路径不存在，会分配内存并且Reset
+     */
+    void SetIR(size_t input, size_t output, std::span<const float> ir) {
+        assert(input < num_inputs_ && output < num_outputs_);
+        auto& frames = ir_frames_[output * num_inputs_ + input];
+        const size_t num_partitions = (ir.size() + block_size_ - 1) / block_size_;
+        frames.Resize(num_partitions, fft_.NumBins());
+        for (size_t i = 0; i < num_partitions; ++i) {
+            auto part = ir.subspan(i * block_size_, std::min(block_size_, ir.size() - i * block_size_));
+            window::Helper::ZeroPad(buffer_, part);
+            fft_.FFT(buffer_, output_frame_);
+            frames.Set(i, output_frame_);
+        }
+        size_t max_partitions = 1;
+        for (const auto& f : ir_frames_) {
+            max_partitions = std::max(max_partitions, f.Size());
+        }
+        ResizeDelayLine(max_partitions);
+        Reset();
+    }
+
+    void Reset() noexcept {
+        for (auto& fdl : input_frames_) {
+            fdl.Reset();
+        }
+        for (auto& b : input_buffers_) {
+            std::fill(b.begin(), b.end(), 0.0f);
+        }
+        for (auto& b : output_buffers_) {
+            std::fill(b.begin(), b.end(), 0.0f);
+        }
+        hop_pos_ = 0;
+    }
+
+    /**
+     * @param inputs num_inputs个通道
+     * @param outputs num_outputs个通道，长度和输入一样，可以和输入是同一块内存
+     */
+    void Process(std::span<const std::span<const float>> inputs, std::span<const std::span<float>> outputs) noexcept {
+        assert(inputs.size() == num_inputs_);
+        assert(outputs.size() == num_outputs_);
+        const size_t num_samples = inputs.front().size();
+        size_t pos = 0;
+        while (pos < num_samples) {
+            const size_t num = std::min(block_size_ - hop_pos_, num_samples - pos);
+            // 先读完所有输入再写输出，这样原地处理也没问题
+            for (size_t m = 0; m < num_inputs_; ++m) {
+                assert(inputs[m].size() == num_samples);
+                std::copy_n(inputs[m].begin() + pos, num, input_buffers_[m].begin() + block_size_ + hop_pos_);
+            }
+            for (size_t n = 0; n < num_outputs_; ++n) {
+                assert(outputs[n].size() == num_samples);
+                std::copy_n(output_buffers_[n].begin() + hop_pos_, num, outputs[n].begin() + pos);
+            }
+            pos += num;
+            hop_pos_ += num;
+            if (hop_pos_ >= block_size_) {
+                hop_pos_ = 0;
+                ProcessHop();
+            }
+        }
+    }
+
+    size_t GetLatency() const noexcept {
+        return block_size_;
+    }
+
+    size_t NumInputs() const noexcept {
+        return num_inputs_;
+    }
+
+    size_t NumOutputs() const noexcept {
+        return num_outputs_;
+    }
+private:
+    void ResizeDelayLine(size_t num_partitions) {
+        for (auto& fdl : input_frames_) {
+            fdl.Resize(num_partitions, fft_.NumBins());
+        }
+    }
+
+    void ProcessHop() noexcept {
+        for (size_t m = 0; m < num_inputs_; ++m) {
+            auto& input = input_buffers_[m];
+            fft_.FFT(input, output_frame_);
+            input_frames_[m].Push(output_frame_);
+            std::copy_n(input.begin() + block_size_, block_size_, input.begin());
+        }
+
+        for (size_t n = 0; n < num_outputs_; ++n) {
+            for (size_t m = 0; m < num_inputs_; ++m) {
+                input_frames_[m].MultiplyAccumulate(ir_frames_[n * num_inputs_ + m], output_frame_, m != 0);
+            }
+            fft_.IFFT(buffer_, output_frame_);
+            // overlap-save，前L个是循环卷积的混叠
+            std::copy_n(buffer_.begin() + block_size_, block_size_, output_buffers_[n].begin());
+        }
+    }
+
+    size_t num_inputs_{};
+    size_t num_outputs_{};
+    size_t block_size_{};
+    spectral::RealFFT<> fft_;
+    std::vector<float> buffer_;
+    spectral::SplitSpectrum<> output_frame_;
+
+    // [output * num_inputs + input]
+    std::vector<spectral::SpectrumArray> ir_frames_;
+    // 每个输入一条频谱延迟线，所有输出共用
+    std::vector<spectral::FrequencyDelayLine> input_frames_;
+
+    // 每个输入最近的2L个采样
+    std::vector<std::vector<float>> input_buffers_;
+    // 每个输出下一个hop要输出的L个采样
+    std::vector<std::vector<float>> output_buffers_;
+    size_t hop_pos_{};
+};
+}
\ No newline at end of file
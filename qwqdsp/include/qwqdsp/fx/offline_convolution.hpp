@@ -0,0 +1,142 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstddef>
+#include <span>
+#include <thread>
+#include <vector>
+#include "qwqdsp/spectral/real_fft.hpp"
+
+namespace qwqdsp::fx {
+/**
+ * @brief 离线的overlap-save快速卷积，整个文件一次算完，用于批量渲染
+ *        IR的频谱只算一次，信号按FFT块分给多个线程，每个块的输出互不重叠，线程之间不需要同步
+ */
+class OfflineConvolution {
+public:
+    /**
+     * @brief 每个输出采样的运算量 (N*log2(N) + 2N) / (N - M + 1) 最小的2的幂
+     *        不会超过整个输出的长度
+     * @param ir_size M
+     * @param output_size 完整输出的长度，0表示不限制
+     */
+    static size_t OptimalFFTSize(size_t ir_size, size_t output_size = 0) noexcept {
+        size_t fft_size = kMinFFTSize;
+        while (fft_size < ir_size * 2) {
+            fft_size *= 2;
+        }
+        size_t best = fft_size;
+        double best_cost = Cost(fft_size, ir_size);
+        for (size_t n = fft_size * 2; n <= kMaxFFTSize; n *= 2) {
+            if (output_size != 0 && n / 2 >= output_size + ir_size - 1) {
+                break;
+            }
+            const double cost = Cost(n, ir_size);
+            if (cost < best_cost) {
+                best_cost = cost;
+                best = n;
+            }
+        }
+        return best;
+    }
+
+    /**
+     * @param num_threads 0表示使用所有的硬件线程
+     */
+    void SetNumThreads(size_t num_threads) noexcept {
+        num_threads_ = num_threads;
+    }
+
+    /**
+     * @brief 完整的线性卷积 y = x * h
+     * @return 长度为x.size() + h.size() - 1，有一个为空时返回空
+     */
+    std::vector<float> Convolve(std::span<const float> x, std::span<const float> h) const {
+        if (x.empty() || h.empty()) {
+            return {};
+        }
+        const size_t ir_size = h.size();
+        const size_t output_size = x.size() + ir_size - 1;
+        size_t num_threads = num_threads_;
+        if (num_threads == 0) {
+            num_threads = std::max<size_t>(1, std::thread::hardware_concurrency());
+        }
+
+        // 块数不够分给所有线程时缩小FFT，比让线程闲着快
+        size_t fft_size = OptimalFFTSize(ir_size, output_size);
+        const size_t min_fft_size = OptimalFFTSize(ir_size, 1);
+        while (fft_size > min_fft_size && NumBlocks(fft_size, ir_size, output_size) < num_threads) {
+            fft_size /= 2;
+        }
+        const size_t hop = fft_size - ir_size + 1;
+        const size_t num_blocks = NumBlocks(fft_size, ir_size, output_size);
+        num_threads = std::min(num_threads, num_blocks);
+
+        spectral::RealFFT<> fft;
+        fft.Init(fft_size, spectral::FFTBackend::kSimd);
+        std::vector<float> buffer(fft_size);
+        spectral::SplitSpectrum<> ir_spectrum;
+        ir_spectrum.Resize(fft.NumBins());
+        std::copy(h.begin(), h.end(), buffer.begin());
+        fft.FFT(buffer, ir_spectrum);
+
+        std::vector<float> y(output_size);
+        std::atomic<size_t> next_block{0};
+        auto worker = [&] {
+            spectral::RealFFT<> block_fft;
+            block_fft.Init(fft_size, spectral::FFTBackend::kSimd);
+            std::vector<float> block(fft_size);
+            spectral::SplitSpectrum<> spectrum;
+            spectrum.Resize(block_fft.NumBins());
+            for (;;) {
+                const size_t b = next_block.fetch_add(1, std::memory_order_relaxed);
+                if (b >= num_blocks) {
+                    break;
+                }
+                // 输出[begin, begin + hop)需要输入[begin - M + 1, begin + hop)，超出x的部分补零
+                const size_t begin = b * hop;
+                const size_t pad = begin < ir_size - 1 ? ir_size - 1 - begin : 0;
+                const size_t x_begin = begin + pad - (ir_size - 1);
+                const size_t x_num = x_begin < x.size() ? std::min(fft_size - pad, x.size() - x_begin) : 0;
+                std::fill_n(block.begin(), pad, 0.0f);
+                std::copy_n(x.begin() + static_cast<std::ptrdiff_t>(std::min(x_begin, x.size())), x_num, block.begin() + static_cast<std::ptrdiff_t>(pad));
+                std::fill(block.begin() + static_cast<std::ptrdiff_t>(pad + x_num), block.end(), 0.0f);
+
+                block_fft.FFT(block, spectrum);
+                spectrum.Multiply(spectrum, ir_spectrum);
+                block_fft.IFFT(block, spectrum);
+                // overlap-save，前M-1个是循环卷积的混叠
+                const size_t num = std::min(hop, output_size - begin);
+                std::copy_n(block.begin() + static_cast<std::ptrdiff_t>(ir_size - 1), num, y.begin() + static_cast<std::ptrdiff_t>(begin));
+            }
+        };
+
+        std::vector<std::thread> threads;
+        threads.reserve(num_threads - 1);
+        for (size_t i = 1; i < num_threads; ++i) {
+            threads.emplace_back(worker);
+        }
+        worker();
+        for (auto& t : threads) {
+            t.join();
+        }
+        return y;
+    }
+private:
+    static constexpr size_t kMinFFTSize = 64;
+    static constexpr size_t kMaxFFTSize = 1 << 20;
+
+    static double Cost(size_t fft_size, size_t ir_size) noexcept {
+        const double n = static_cast<double>(fft_size);
+        return (n * std::log2(n) + 2.0 * n) / static_cast<double>(fft_size - ir_size + 1);
+    }
+
+    static size_t NumBlocks(size_t fft_size, size_t ir_size, size_t output_size) noexcept {
+        const size_t hop = fft_size - ir_size + 1;
+        return (output_size + hop - 1) / hop;
+    }
+
+    size_t num_threads_{};
+};
+}
\ No newline at end of file
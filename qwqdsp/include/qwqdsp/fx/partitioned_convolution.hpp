@@ -0,0 +1,561 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <thread>
+#include <vector>
+#include "qwqdsp/filter/fir.hpp"
+#include "qwqdsp/spectral/frequency_delay_line.hpp"
+#include "qwqdsp/spectral/real_fft.hpp"
+#include "qwqdsp/segement/slice.hpp"
+#include "qwqdsp/window/helper.hpp"
+
+namespace qwqdsp::fx {
+namespace internal {
+/**
+ * @brief 一段均匀分区的overlap-save卷积，分区大小L，FFT大小2L
+ */
+class ConvolutionStage {
+public:
+    /**
+     * @param block_size L
+     * @param ir 这一段负责的IR，分成ceil(size / L)个分区
+     */
+    void Init(size_t block_size, std::span<const float> ir) {
+        block_size_ = block_size;
+        fft_.Init(block_size * 2);
+        buffer_.resize(block_size * 2);
+        const size_t num_partitions = (ir.size() + block_size - 1) / block_size;
+        output_frame_.Resize(fft_.NumBins());
+        ir_frames_.Resize(num_partitions, fft_.NumBins());
+        input_frames_.Resize(num_partitions, fft_.NumBins());
+        for (size_t i = 0; i < num_partitions; ++i) {
+            auto part = ir.subspan(i * block_size, std::min(block_size, ir.size() - i * block_size));
+            window::Helper::ZeroPad(buffer_, part);
+            fft_.FFT(buffer_, output_frame_);
+            ir_frames_.Set(i, output_frame_);
+        }
+        Reset();
+    }
+
+    void Reset() noexcept {
+        input_frames_.Reset();
+    }
+
+    /**
+     * @param input 最近的2L个输入采样
+     * @param output 累加L个输出采样
+     */
+    void Process(std::span<const float> input, std::span<float> output) noexcept {
+        assert(input.size() == block_size_ * 2);
+        assert(output.size() == block_size_);
+        fft_.FFT(input, output_frame_);
+        input_frames_.Push(output_frame_);
+        input_frames_.MultiplyAccumulate(ir_frames_, output_frame_, false);
+        fft_.IFFT(buffer_, output_frame_);
+        // overlap-save，前L个是循环卷积的混叠
+        for (size_t i = 0; i < block_size_; ++i) {
+            output[i] += buffer_[block_size_ + i];
+        }
+    }
+
+    /**
+     * @brief 只把输入放进频谱历史，不计算输出，用于已经赶不上的hop
+     * @param input 最近的2L个输入采样
+     */
+    void Push(std::span<const float> input) noexcept {
+        assert(input.size() == block_size_ * 2);
+        fft_.FFT(input, output_frame_);
+        input_frames_.Push(output_frame_);
+    }
+
+    size_t BlockSize() const noexcept {
+        return block_size_;
+    }
+
+    size_t NumPartitions() const noexcept {
+        return ir_frames_.Size();
+    }
+private:
+    size_t block_size_{};
+    spectral::RealFFT<> fft_;
+    std::vector<float> buffer_;
+    spectral::SpectrumArray ir_frames_;
+    spectral::FrequencyDelayLine input_frames_;
+    spectral::SplitSpectrum<> output_frame_;
+};
+
+/**
+ * @brief 在后台线程计算大分区
+ *        音频线程在时刻t提交输入，结果在t + kSlots * L才叠加到输出，每段有kQueueSize个任务轮流使用
+ *        平均每L个采样只需要算一个任务，所以每个任务有(kSlots - 1) * L的余量，正常情况下会提前算完
+ *        同时有多个任务等待时先算截止时间最早的，同一段的任务按顺序计算
+ *        已经过了截止时间的任务只做FFT放进频谱历史，跳过乘加和IFFT，让worker尽快追上
+ *        交接只用原子变量，音频线程不会拿锁，不会等待，也不会替worker计算，worker醒着的时候唤醒也不会有系统调用
+ */
+class ConvolutionWorker {
+public:
+    static constexpr size_t kSlots = 2;
+    // 每段的任务数，比kSlots多出来的任务在worker迟到时继续接收输入，保持频谱历史完整
+    static constexpr size_t kQueueSize = 4;
+
+    enum State : uint32_t {
+        kIdle,
+        kPending,
+        kRunning,
+        kDone
+    };
+
+    struct Job {
+        ConvolutionStage* stage{};
+        std::vector<float> input;
+        std::vector<float> output;
+        std::atomic<size_t> deadline{};
+        std::atomic<uint32_t> state{kIdle};
+        // 计算之前先清空这一段的频谱历史，在发布kPending之前写好
+        bool reset_stage{};
+        // 只有音频线程访问
+        bool issued{};
+        // 结果应该叠加到的输出位置
+        size_t output_pos{};
+    };
+
+    explicit ConvolutionWorker(std::span<ConvolutionStage* const> stages)
+        : num_jobs_(stages.size() * kQueueSize)
+        , jobs_(std::make_unique<Job[]>(stages.size() * kQueueSize))
+    {
+        for (size_t i = 0; i < num_jobs_; ++i) {
+            ConvolutionStage* stage = stages[i / kQueueSize];
+            const size_t size = stage->BlockSize();
+            jobs_[i].stage = stage;
+            jobs_[i].input.resize(size * 2);
+            jobs_[i].output.resize(size);
+        }
+        thread_ = std::thread([this] {
+            Loop();
+        });
+    }
+
+    ~ConvolutionWorker() {
+        quit_.store(true, std::memory_order_release);
+        Notify();
+        thread_.join();
+    }
+
+    ConvolutionWorker(const ConvolutionWorker&) = delete;
+    ConvolutionWorker& operator=(const ConvolutionWorker&) = delete;
+
+    /**
+     * @brief 第stage个异步段的第slot个任务
+     */
+    Job& GetJob(size_t stage, size_t slot) noexcept {
+        return jobs_[stage * kQueueSize + slot];
+    }
+
+    /**
+     * @brief 音频线程，当前的输出位置，截止时间早于它的任务只更新频谱历史
+     */
+    void SetNow(size_t now) noexcept {
+        now_.store(now, std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief 音频线程，job.input已经写好，不会唤醒worker，提交完这一轮之后调用一次Notify
+     */
+    void Submit(Job& job, size_t deadline) noexcept {
+        job.deadline.store(deadline, std::memory_order_relaxed);
+        job.state.store(kPending, std::memory_order_release);
+        job.issued = true;
+    }
+
+    /**
+     * @brief 音频线程，唤醒worker，worker没有睡着的时候不会进入内核
+     */
+    void Notify() noexcept {
+        // 和Loop里的sleeping_ -> generation_配对，两边都是seq_cst，至少有一边能看到对方
+        generation_.fetch_add(1, std::memory_order_seq_cst);
+        if (sleeping_.load(std::memory_order_seq_cst)) {
+            generation_.notify_one();
+        }
+    }
+
+    /**
+     * @brief 音频线程，结果是否可以读，可以的时候这个任务可以重新提交
+     */
+    static bool IsDone(const Job& job) noexcept {
+        return job.state.load(std::memory_order_acquire) == kDone;
+    }
+
+    /**
+     * @brief 放弃任务，不等待。还没开始的直接取消，正在算的让它算完，结果不会被使用
+     * @return 任务是否已经空闲，可以重新提交
+     */
+    static bool Cancel(Job& job) noexcept {
+        if (!job.issued) {
+            return true;
+        }
+        uint32_t expected = kPending;
+        if (job.state.compare_exchange_strong(expected, kIdle, std::memory_order_acq_rel) || expected == kDone) {
+            job.issued = false;
+            return true;
+        }
+        // 之后变成kDone时output_pos对不上，结果会被丢掉
+        job.output_pos = static_cast<size_t>(-1);
+        return false;
+    }
+private:
+    static void Run(Job& job, bool late) noexcept {
+        if (job.reset_stage) {
+            job.stage->Reset();
+        }
+        if (late) {
+            job.stage->Push(job.input);
+            return;
+        }
+        std::fill(job.output.begin(), job.output.end(), 0.0f);
+        job.stage->Process(job.input, job.output);
+    }
+
+    void Loop() noexcept {
+        for (;;) {
+            const uint32_t generation = generation_.load(std::memory_order_acquire);
+            if (quit_.load(std::memory_order_acquire)) {
+                return;
+            }
+            Job* next = nullptr;
+            size_t next_deadline = 0;
+            for (size_t i = 0; i < num_jobs_; ++i) {
+                auto& job = jobs_[i];
+                if (job.state.load(std::memory_order_acquire) != kPending) {
+                    continue;
+                }
+                const size_t deadline = job.deadline.load(std::memory_order_relaxed);
+                if (next == nullptr || deadline < next_deadline) {
+                    next = &job;
+                    next_deadline = deadline;
+                }
+            }
+            if (next == nullptr) {
+                // 先声明要睡了再检查一次，扫描之后提交的任务会让generation_变化
+                sleeping_.store(true, std::memory_order_seq_cst);
+                if (generation_.load(std::memory_order_seq_cst) == generation) {
+                    generation_.wait(generation, std::memory_order_acquire);
+                }
+                sleeping_.store(false, std::memory_order_relaxed);
+                continue;
+            }
+            uint32_t expected = kPending;
+            if (next->state.compare_exchange_strong(expected, kRunning, std::memory_order_acq_rel)) {
+                // 截止时间等于now的任务音频线程可能还没来得及检查，照常计算
+                Run(*next, next_deadline < now_.load(std::memory_order_relaxed));
+                next->state.store(kDone, std::memory_order_release);
+            }
+        }
+    }
+
+    size_t num_jobs_{};
+    std::unique_ptr<Job[]> jobs_;
+    std::atomic<uint32_t> generation_{};
+    // worker在generation_上等待的时候为true，Notify只在这时调用notify_one
+    std::atomic<bool> sleeping_{};
+    std::atomic<bool> quit_{};
+    std::atomic<size_t> now_{};
+    std::thread thread_;
+};
+}
+
+/**
+ * @brief 非均匀分区卷积，延迟和UniformConvolution一样，但是后面的分区越来越大
+ *        IR前面用L = latency的分区，每kStagePartitions个分区之后分区大小翻倍，直到max_partition_size
+ *        长IR的乘加次数从O(IR长度 / latency)降低到O(log)，适合长混响
+ *        分区大小为L的段起始位置满足 offset >= L - latency，多出来的部分在时域延迟输入
+ *        零延迟模式下IR的前latency个采样用FIRDirect直接卷积，FFT部分的条件变成 offset >= L
+ *        SetAsync之后大分区放到后台线程计算，这些段多留kSlots * L的余量，条件变成 offset >= (kSlots + 1)L - latency
+ *        音频线程每个hop的开销只有同步的小分区、异步段输入输出的拷贝，worker睡着的时候再加一次唤醒
+ *        worker没有在截止时间前算完时，这一段这一个hop的L个输出是0，音频线程不会等待也不会替它计算
+ *        听起来是尾音里这一段IR负责的部分短暂缺一块(L个采样的轻微下陷)，频谱历史照常更新，下一个hop就恢复
+ *        worker落后超过kQueueSize - kSlots个hop时这一段才丢掉输入，从空的历史重新开始，
+ *        之后这一段IR长度内的尾音都会变薄，NumDeadlineMiss()记录迟到的次数
+ */
+class PartitionedConvolution {
+public:
+    static constexpr size_t kStagePartitions = 4;
+    static constexpr size_t kHeadBatchSize = 64;
+
+    /**
+     * @param latency 最小的分区大小，最好是2的幂
+     * @param max_partition_size 最大的分区大小，会被对齐到latency * 2^n，越大平均开销越小但是单次处理的峰值越高
+     * @param zero_latency true: 没有延迟，代价是每个采样多latency次乘加，输出和直接卷积一致
+     */
+    void Init(size_t latency, size_t max_partition_size = 8192, bool zero_latency = false) {
+        assert(latency > 0);
+        latency_ = latency;
+        zero_latency_ = zero_latency;
+        head_output_.resize(latency);
+        max_partition_size_ = latency;
+        while (max_partition_size_ * 2 <= max_partition_size) {
+            max_partition_size_ *= 2;
+        }
+        hop_pos_ = 0;
+        wpos_ = 0;
+    }
+
+    /**
+     * @brief 分区大小>=min_partition_size的段在后台线程计算，音频线程只负责前面的小分区，需要在SetIR之前调用
+     * @param min_partition_size 0: 不使用后台线程
+     */
+    void SetAsync(size_t min_partition_size) noexcept {
+        async_partition_size_ = min_partition_size;
+    }
+
+    /**
+     * @brief 会分配内存并且Reset，有后台线程时会重新创建线程
+     */
+    void SetIR(std::span<const float> ir) {
+        worker_.reset();
+        jobs_.clear();
+        stages_.clear();
+        delays_.clear();
+        size_t offset = 0;
+        size_t output_delay = latency_;
+        if (zero_latency_) {
+            const auto head = ir.first(std::min(latency_, ir.size()));
+            head_.SetCoeff([head](std::vector<float>& coeff) {
+                coeff.assign(head.begin(), head.end());
+            });
+            offset = head.size();
+            output_delay = 0;
+        }
+        size_t size = latency_;
+        std::vector<bool> async_stages;
+        size_t max_size = latency_;
+        size_t max_input = latency_ * 2;
+        while (offset < ir.size()) {
+            const size_t remain = ir.size() - offset;
+            size_t num_partitions = (remain + size - 1) / size;
+            if (size < max_partition_size_) {
+                num_partitions = std::min(num_partitions, kStagePartitions);
+            }
+            const size_t len = std::min(remain, num_partitions * size);
+            auto& stage = stages_.emplace_back();
+            stage.Init(size, ir.subspan(offset, len));
+            // offset >= size - output_delay由翻倍的条件保证
+            // 后台线程计算的段再留出kSlots * size的余量，不够的段还是在音频线程计算
+            constexpr size_t kSlots = internal::ConvolutionWorker::kSlots;
+            const bool async = async_partition_size_ != 0
+                && size >= async_partition_size_
+                && offset + output_delay >= size * (kSlots + 1);
+            const size_t delay = offset + output_delay - size - (async ? size * kSlots : 0);
+            delays_.push_back(delay);
+            async_stages.push_back(async);
+            max_size = size;
+            max_input = std::max(max_input, delay + size * 2);
+            offset += len;
+            if (size < max_partition_size_) {
+                size *= 2;
+            }
+        }
+
+        input_buffer_.resize(NextPowerOfTwo(max_input + latency_));
+        output_buffer_.resize(NextPowerOfTwo(max_size + latency_));
+        stage_input_.resize(max_size * 2);
+        stage_output_.resize(max_size);
+
+        std::vector<internal::ConvolutionStage*> async_list;
+        for (size_t i = 0; i < stages_.size(); ++i) {
+            if (async_stages[i]) {
+                async_list.push_back(&stages_[i]);
+            }
+        }
+        jobs_.resize(stages_.size());
+        restart_.assign(stages_.size(), false);
+        if (!async_list.empty()) {
+            worker_ = std::make_unique<internal::ConvolutionWorker>(async_list);
+            size_t job_idx = 0;
+            for (size_t i = 0; i < stages_.size(); ++i) {
+                if (async_stages[i]) {
+                    jobs_[i] = &worker_->GetJob(job_idx++, 0);
+                }
+            }
+        }
+        num_deadline_miss_ = 0;
+        Reset();
+    }
+
+    /**
+     * @brief 不会等待后台线程，异步段的历史在下一个任务开始前由后台线程清空
+     */
+    void Reset() noexcept {
+        for (size_t s = 0; s < stages_.size(); ++s) {
+            if (jobs_[s] == nullptr) {
+                stages_[s].Reset();
+                continue;
+            }
+            for (size_t slot = 0; slot < internal::ConvolutionWorker::kQueueSize; ++slot) {
+                internal::ConvolutionWorker::Cancel(jobs_[s][slot]);
+            }
+            restart_[s] = true;
+        }
+        head_.Reset();
+        std::fill(input_buffer_.begin(), input_buffer_.end(), 0.0f);
+        std::fill(output_buffer_.begin(), output_buffer_.end(), 0.0f);
+        hop_pos_ = 0;
+        wpos_ = 0;
+    }
+
+    void Process(std::span<float> block) noexcept {
+        const size_t input_mask = input_buffer_.size() - 1;
+        const size_t output_mask = output_buffer_.size() - 1;
+        segement::Slice1D input{block};
+        while (!input.IsEnd()) {
+            size_t need = latency_ - hop_pos_;
+            auto in = input.GetSome(need);
+            if (zero_latency_) {
+                // FFT部分在上一个hop结束时已经算好了这一个hop的输出
+                head_.Process(in, {head_output_.data(), in.size()});
+                for (size_t i = 0; i < in.size(); ++i) {
+                    const size_t pos = wpos_ + i;
+                    input_buffer_[pos & input_mask] = in[i];
+                    in[i] = head_output_[i] + output_buffer_[pos & output_mask];
+                    output_buffer_[pos & output_mask] = 0.0f;
+                }
+            }
+            else {
+                for (size_t i = 0; i < in.size(); ++i) {
+                    const size_t pos = wpos_ + i;
+                    input_buffer_[pos & input_mask] = in[i];
+                    in[i] = output_buffer_[pos & output_mask];
+                    output_buffer_[pos & output_mask] = 0.0f;
+                }
+            }
+            wpos_ += in.size();
+            hop_pos_ += in.size();
+            if (hop_pos_ >= latency_) {
+                hop_pos_ = 0;
+                ProcessStages();
+            }
+        }
+    }
+
+    size_t GetLatency() const noexcept {
+        return zero_latency_ ? 0 : latency_;
+    }
+
+    size_t NumStages() const noexcept {
+        return stages_.size();
+    }
+
+    /**
+     * @brief 后台线程没有按时算完的次数，不为0说明后台线程太慢，有分区的输出被丢掉了
+     */
+    size_t NumDeadlineMiss() const noexcept {
+        return num_deadline_miss_;
+    }
+private:
+    static size_t NextPowerOfTwo(size_t x) noexcept {
+        size_t n = 1;
+        while (n < x) {
+            n *= 2;
+        }
+        return n;
+    }
+
+    /**
+     * @brief 每个分区大小为L的段每L个采样处理一次，结果叠加到输出的[wpos, wpos + L)
+     */
+    void ProcessStages() noexcept {
+        const size_t input_mask = input_buffer_.size() - 1;
+        const size_t output_mask = output_buffer_.size() - 1;
+        bool submitted = false;
+        if (worker_ != nullptr) {
+            worker_->SetNow(wpos_);
+        }
+        for (size_t s = 0; s < stages_.size(); ++s) {
+            auto& stage = stages_[s];
+            const size_t size = stage.BlockSize();
+            if (wpos_ % size != 0) {
+                continue;
+            }
+            const size_t begin = wpos_ - delays_[s] - size * 2;
+            if (jobs_[s] != nullptr) {
+                constexpr size_t kSlots = internal::ConvolutionWorker::kSlots;
+                constexpr size_t kQueueSize = internal::ConvolutionWorker::kQueueSize;
+                const size_t hop = wpos_ / size;
+                // kSlots个hop之前提交的结果属于[wpos, wpos + L)
+                auto& due = jobs_[s][(hop + kQueueSize - kSlots) % kQueueSize];
+                if (due.issued && due.output_pos == wpos_) {
+                    if (internal::ConvolutionWorker::IsDone(due)) {
+                        for (size_t i = 0; i < size; ++i) {
+                            output_buffer_[(wpos_ + i) & output_mask] += due.output[i];
+                        }
+                        due.issued = false;
+                    }
+                    else {
+                        // 没有按时算完，这个hop的输出不要了，任务留着让worker把输入放进历史
+                        ++num_deadline_miss_;
+                        due.output_pos = static_cast<size_t>(-1);
+                    }
+                }
+                auto& job = jobs_[s][hop % kQueueSize];
+                if (job.issued && internal::ConvolutionWorker::IsDone(job)) {
+                    job.issued = false;
+                }
+                if (job.issued) {
+                    // kQueueSize个hop之前的任务还没做完，这一块输入只能丢掉，之后的频谱历史对不上了，从头开始
+                    restart_[s] = true;
+                    continue;
+                }
+                for (size_t i = 0; i < size * 2; ++i) {
+                    job.input[i] = input_buffer_[(begin + i) & input_mask];
+                }
+                job.reset_stage = restart_[s];
+                restart_[s] = false;
+                job.output_pos = wpos_ + size * kSlots;
+                worker_->Submit(job, job.output_pos);
+                submitted = true;
+                continue;
+            }
+            for (size_t i = 0; i < size * 2; ++i) {
+                stage_input_[i] = input_buffer_[(begin + i) & input_mask];
+            }
+            std::fill_n(stage_output_.begin(), size, 0.0f);
+            stage.Process({stage_input_.data(), size * 2}, {stage_output_.data(), size});
+            for (size_t i = 0; i < size; ++i) {
+                output_buffer_[(wpos_ + i) & output_mask] += stage_output_[i];
+            }
+        }
+        if (submitted) {
+            worker_->Notify();
+        }
+    }
+
+    size_t latency_{};
+    size_t max_partition_size_{};
+    bool zero_latency_{};
+    filter::FIRDirect<kHeadBatchSize> head_;
+    std::vector<float> head_output_;
+    std::vector<internal::ConvolutionStage> stages_;
+    // 每一段输入的时域延迟
+    std::vector<size_t> delays_;
+    size_t async_partition_size_{};
+    // 和stages_一一对应，指向连续的kQueueSize个任务，nullptr表示在音频线程计算
+    std::vector<internal::ConvolutionWorker::Job*> jobs_;
+    std::unique_ptr<internal::ConvolutionWorker> worker_;
+    // 下一个任务需要先清空这一段的频谱历史，只有音频线程访问
+    std::vector<bool> restart_;
+    size_t num_deadline_miss_{};
+
+    // 长度都是2的幂，用wpos_ & mask寻址
+    std::vector<float> input_buffer_;
+    std::vector<float> output_buffer_;
+    size_t wpos_{};
+    size_t hop_pos_{};
+
+    std::vector<float> stage_input_;
+    std::vector<float> stage_output_;
+};
+}
\ No newline at end of file
@@ -1,6 +1,11 @@
 #pragma once
 #include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cassert>
 #include <cstddef>
+#include <memory>
+#include "qwqdsp/spectral/frequency_delay_line.hpp"
 #include "qwqdsp/spectral/real_fft.hpp"
 #include "qwqdsp/segement/analyze_auto.hpp"
 #include "qwqdsp/segement/slice.hpp"
@@ -9,50 +14,134 @@
 namespace qwqdsp::fx {
 class UniformConvolution {
 public:
-    void Init(size_t latency) {
+    using Frame = spectral::SplitSpectrum<>;
+
+    /**
+     * @brief 在任意线程准备好的IR频谱，通过ScheduleIR交给音频线程
+     */
+    struct PreparedIR {
+        spectral::SpectrumArray frames;
+    };
+
+    UniformConvolution() = default;
+    UniformConvolution(const UniformConvolution&) = delete;
+    UniformConvolution& operator=(const UniformConvolution&) = delete;
+
+    ~UniformConvolution() {
+        delete pending_.exchange(nullptr, std::memory_order_acquire);
+        CollectRetiredIR();
+    }
+
+    /**
+     * @param max_ir_size 之后ScheduleIR的IR最长是多少，音频线程不能扩大输入的频谱缓冲
+     *        为0时只有一个分区，热切换更长的IR之前必须用SetIR或者这里预留，见GetMaxIRSize
+     */
+    void Init(size_t latency, size_t max_ir_size = 0) {
         size_t fft_size = latency * 2;
         block_size_ = latency;
         fft_.Init(fft_size);
         if (input_buffer_.size() < latency) {
             input_buffer_.resize(latency);
         }
+        // 未读的采样加上一帧不会超过2 * fft_size
         if (output_buffer_.size() < fft_size * 2) {
-            output_buffer_.resize(fft_size * 2);
+            output_buffer_.resize(std::bit_ceil(fft_size * 2));
         }
+        output_mask_ = output_buffer_.size() - 1;
         process_buffer_.resize(fft_size);
+        crossfade_buffer_.resize(fft_size);
+        output_frame_.Resize(fft_.NumBins());
+        ReserveFrames((max_ir_size + latency - 1) / latency);
+        SetCrossfade(kDefaultCrossfade);
         Reset();
     }
 
+    /**
+     * @brief 交叉淡化的长度，对齐到latency
+     */
+    void SetCrossfade(size_t num_samples) noexcept {
+        crossfade_hops_ = std::max<size_t>(1, (num_samples + block_size_ - 1) / block_size_);
+    }
+
     void Reset() noexcept {
-        std::fill_n(output_buffer_.begin(), write_end_, 0.0f);
-        for (auto& f : input_frames_) {
-            std::fill(f.begin(), f.end(), std::complex<float>{});
+        std::fill(output_buffer_.begin(), output_buffer_.end(), 0.0f);
+        input_frames_.Reset();
+        if (next_ != nullptr) {
+            // 直接切换到新的IR
+            RetireIR();
         }
         input_wpos_ = 0;
-        input_frame_wpos_ = 0;
-        write_end_ = 0;
+        output_rpos_ = 0;
         write_add_end_ = 0;
     }
 
-    void SetIR(std::span<float> ir) noexcept {
+    /**
+     * @brief 阻塞地换掉IR，会分配内存并且Reset，不要在音频线程调用
+     */
+    void SetIR(std::span<const float> ir) {
+        ReserveFrames((ir.size() + block_size_ - 1) / block_size_);
+        ir_ = PrepareIR(ir);
+        next_.reset();
+        Reset();
+    }
+
+    /**
+     * @brief 热切换的IR最长是多少，由Init的max_ir_size和之前SetIR的长度决定
+     */
+    size_t GetMaxIRSize() const noexcept {
+        return input_frames_.Depth() * block_size_;
+    }
+
+    /**
+     * @brief 可以在任意线程调用，会分配内存
+     *        超过GetMaxIRSize()的部分会被截断，debug下会断言
+     */
+    std::unique_ptr<PreparedIR> PrepareIR(std::span<const float> ir) const {
+        assert(ir.size() <= GetMaxIRSize() && "IR longer than max_ir_size is truncated");
+        spectral::RealFFT<> fft;
+        fft.Init(block_size_ * 2);
+        std::vector<float> buffer(block_size_ * 2);
+        auto prepared = std::make_unique<PreparedIR>();
         segement::AnalyzeAuto<true> analyze;
         analyze.SetSize(block_size_);
         analyze.SetHop(block_size_);
-        size_t num_frame = analyze.GetMinFrameSize(ir.size());
-        ir_frames_.resize(num_frame);
-        input_frames_.resize(num_frame);
-        for (size_t i = 0; i < num_frame; ++i) {
-            ir_frames_[i].resize(fft_.NumBins());
-            input_frames_[i].resize(fft_.NumBins());
-        }
-        output_frame_.resize(fft_.NumBins());
+        const size_t num_frame = std::min(analyze.GetMinFrameSize(ir.size()), input_frames_.Depth());
+        prepared->frames.Resize(num_frame, fft.NumBins());
+        Frame frame;
+        frame.Resize(fft.NumBins());
         size_t i = 0;
-        analyze.Process(ir, [this, &i](std::span<const float> block) {
-            window::Helper::ZeroPad(process_buffer_, block);
-            fft_.FFT(process_buffer_, ir_frames_[i]);
+        analyze.Process(ir, [&](std::span<const float> block) {
+            if (i < num_frame) {
+                window::Helper::ZeroPad(buffer, block);
+                fft.FFT(buffer, frame);
+                prepared->frames.Set(i, frame);
+            }
             ++i;
         });
-        Reset();
+        return prepared;
+    }
+
+    /**
+     * @brief 在非音频线程调用，音频线程下一次处理时开始从当前IR交叉淡化到新的IR
+     *        还没被音频线程取走的IR会被替换掉，已经淡出的IR在这里释放
+     */
+    void ScheduleIR(std::unique_ptr<PreparedIR> ir) noexcept {
+        CollectRetiredIR();
+        delete pending_.exchange(ir.release(), std::memory_order_acq_rel);
+    }
+
+    /**
+     * @brief 在非音频线程调用，释放已经淡出的IR
+     */
+    void CollectRetiredIR() noexcept {
+        delete retired_.exchange(nullptr, std::memory_order_acquire);
+    }
+
+    /**
+     * @brief 是否正在交叉淡化
+     */
+    bool IsCrossfading() const noexcept {
+        return next_ != nullptr;
     }
 
     void Process(std::span<float> block) noexcept {
@@ -64,54 +153,50 @@ public:
             input_wpos_ += in.size();
             if (input_wpos_ >= block_size_) {
                 window::Helper::ZeroPad(process_buffer_, input_buffer_);
-                fft_.FFT(process_buffer_, input_frames_[input_frame_wpos_]);
+                fft_.FFT(process_buffer_, output_frame_);
+                input_frames_.Push(output_frame_);
                 input_wpos_ -= block_size_;
 
-                const size_t num_bins = fft_.NumBins();
-                for (size_t i = 0; i < num_bins; ++i) {
-                    output_frame_[i] = input_frames_[input_frame_wpos_][i] * ir_frames_[0][i];
+                // 上一次淡出的IR还没有被释放的话先不换
+                if (next_ == nullptr && retired_.load(std::memory_order_acquire) == nullptr) {
+                    if (auto* pending = pending_.exchange(nullptr, std::memory_order_acquire)) {
+                        next_.reset(pending);
+                        crossfade_pos_ = 0;
+                    }
                 }
-                for (size_t i = 1; i < ir_frames_.size(); ++i) {
-                    size_t idx = input_frame_wpos_ + input_frames_.size() - i;
-                    if (idx >= input_frames_.size()) {
-                        idx -= input_frames_.size();
+
+                Convolve(ir_.get(), process_buffer_);
+                if (next_ != nullptr) {
+                    // 两个IR共用输入的频谱，第一帧的前半段和上一帧重叠所以从后半段开始淡化
+                    Convolve(next_.get(), crossfade_buffer_);
+                    const float crossfade_size = static_cast<float>(crossfade_hops_ * block_size_);
+                    const float begin = static_cast<float>(crossfade_pos_ * block_size_) - static_cast<float>(block_size_);
+                    for (size_t i = 0; i < block_size_ * 2; ++i) {
+                        const float t = std::clamp((begin + static_cast<float>(i)) / crossfade_size, 0.0f, 1.0f);
+                        process_buffer_[i] += (crossfade_buffer_[i] - process_buffer_[i]) * t;
                     }
-                    for (size_t j = 0; j < num_bins; ++j) {
-                        output_frame_[j] += input_frames_[idx][j] * ir_frames_[i][j];
+                    ++crossfade_pos_;
+                    if (crossfade_pos_ > crossfade_hops_) {
+                        RetireIR();
                     }
                 }
 
-                fft_.IFFT(process_buffer_, output_frame_);
-                for (int i = 0; i < block_size_ * 2; i++) {
-                    output_buffer_[i + write_add_end_] += process_buffer_[i];
+                const size_t wpos = output_rpos_ + write_add_end_;
+                for (size_t i = 0; i < block_size_ * 2; i++) {
+                    output_buffer_[(wpos + i) & output_mask_] += process_buffer_[i];
                 }
-                write_end_ = write_add_end_ + block_size_ * 2;
                 write_add_end_ += block_size_;
-                ++input_frame_wpos_;
-                if (input_frame_wpos_ >= ir_frames_.size()) {
-                    input_frame_wpos_ = 0;
-                }
             }
 
             if (write_add_end_ >= in.size()) {
-                // extract output
-                int extractSize = in.size();
-                for (int i = 0; i < extractSize; ++i) {
-                    in[i] = output_buffer_[i];
-                }
-                
-                // shift output buffer
-                int shiftSize = write_end_ - extractSize;
-                for (int i = 0; i < shiftSize; i++) {
-                    output_buffer_[i] = output_buffer_[i + extractSize];
+                // 读出之后清零，下一圈可以直接累加
+                for (size_t i = 0; i < in.size(); ++i) {
+                    float& s = output_buffer_[(output_rpos_ + i) & output_mask_];
+                    in[i] = s;
+                    s = 0.0f;
                 }
-                write_add_end_ -= extractSize;
-                int newWriteEnd = write_end_ - extractSize;
-                // zero shifed buffer
-                for (int i = newWriteEnd; i < write_end_; ++i) {
-                    output_buffer_[i] = 0.0f;
-                }
-                write_end_ = newWriteEnd;
+                output_rpos_ += in.size();
+                write_add_end_ -= in.size();
             }
             else {
                 // zero buffer
@@ -120,20 +205,61 @@ public:
         }
     }
 private:
-    using Frame = std::vector<std::complex<float>>;
+    static constexpr size_t kDefaultCrossfade = 1024;
+
+    void ReserveFrames(size_t num_frame) {
+        num_frame = std::max<size_t>(num_frame, 1);
+        if (input_frames_.Depth() < num_frame || input_frames_.NumBins() != fft_.NumBins()) {
+            input_frames_.Resize(std::max(num_frame, input_frames_.Depth()), fft_.NumBins());
+        }
+    }
+
+    /**
+     * @brief next_变成当前的IR，旧的交给非音频线程释放，音频线程不会释放内存
+     *        只有retired_为空时才会开始交叉淡化，而retired_只在这里写入，所以这时retired_一定是空的
+     */
+    void RetireIR() noexcept {
+        assert(retired_.load(std::memory_order_acquire) == nullptr);
+        retired_.store(ir_.release(), std::memory_order_release);
+        ir_ = std::move(next_);
+    }
+
+    /**
+     * @brief 输入的频谱和ir卷积，时域写入output
+     */
+    void Convolve(const PreparedIR* ir, std::span<float> output) noexcept {
+        if (ir == nullptr || ir->frames.Size() == 0) {
+            std::fill(output.begin(), output.end(), 0.0f);
+            return;
+        }
+        input_frames_.MultiplyAccumulate(ir->frames, output_frame_, false);
+        fft_.IFFT(output, output_frame_);
+    }
 
     size_t block_size_{};
     size_t input_wpos_{};
-    size_t write_end_{};
+    // 从output_rpos_开始已经算完的采样数
     size_t write_add_end_{};
     std::vector<float> input_buffer_;
     std::vector<float> process_buffer_;
+    // 2的幂的环形缓冲
     std::vector<float> output_buffer_;
+    size_t output_mask_{};
+    size_t output_rpos_{};
 
-    spectral::RealFFT fft_;
-    std::vector<Frame> ir_frames_;
-    std::vector<Frame> input_frames_;
-    size_t input_frame_wpos_{};
+    spectral::RealFFT<> fft_;
+    spectral::FrequencyDelayLine input_frames_;
     Frame output_frame_;
+
+    std::unique_ptr<PreparedIR> ir_;
+    // 交叉淡化的目标，只有音频线程访问
+    std::unique_ptr<PreparedIR> next_;
+    std::vector<float> crossfade_buffer_;
+    size_t crossfade_hops_{1};
+    size_t crossfade_pos_{};
+    // 非音频线程 -> 音频线程
+    std::atomic<PreparedIR*> pending_{};
+    // 音频线程 -> 非音频线程
+    std::atomic<PreparedIR*> retired_{};
 };
 }
\ No newline at end of file
@@ -146,7 +146,7 @@ private:
     std::vector<float> powers_;
     std::vector<float> temp_;
 
-    spectral::RealFFT fft_;
+    spectral::RealFFT<> fft_;
     std::vector<std::complex<float>> fft1_;
     std::vector<std::complex<float>> fft2_;
 
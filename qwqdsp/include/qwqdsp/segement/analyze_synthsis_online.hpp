@@ -1,7 +1,9 @@
 #pragma once
 #include <algorithm>
+#include <bit>
 #include <cstddef>
 #include <span>
+#include <vector>
 #include "slice.hpp"
 
 namespace qwqdsp::segement {
@@ -22,41 +24,38 @@ public:
         while (!input.IsEnd()) {
             size_t need = size_ - input_wpos_;
             auto in = input.GetSome(need);
-            std::copy(in.begin(), in.end(), input_buffer_.begin() + input_wpos_);
+            // 镜像写两份，最近的size个采样总是从input_buffer_[input_rpos_]开始连续存放
+            for (size_t i = 0; i < in.size(); ++i) {
+                input_buffer_[input_rpos_] = in[i];
+                input_buffer_[input_rpos_ + size_] = in[i];
+                ++input_rpos_;
+                if (input_rpos_ >= size_) {
+                    input_rpos_ = 0;
+                }
+            }
             input_wpos_ += in.size();
             if (input_wpos_ >= size_) {
-                std::copy(input_buffer_.begin(), input_buffer_.end(), process_buffer_.begin());
-                func(std::span<const float>{input_buffer_.data(), size_}, std::span<float>{process_buffer_.data(), size_});
+                std::span<const float> frame{input_buffer_.data() + input_rpos_, size_};
+                std::copy(frame.begin(), frame.end(), process_buffer_.begin());
+                func(frame, std::span<float>{process_buffer_.data(), size_});
                 input_wpos_ -= hop_;
-                for (int i = 0; i < input_wpos_; i++) {
-                    input_buffer_[i] = input_buffer_[i + hop_];
-                }
-                for (int i = 0; i < size_; i++) {
-                    output_buffer_[i + write_add_end_] += process_buffer_[i];
+                const size_t wpos = output_rpos_ + write_add_end_;
+                for (size_t i = 0; i < size_; i++) {
+                    output_buffer_[(wpos + i) & output_mask_] += process_buffer_[i];
                 }
-                write_end_ = write_add_end_ + size_;
                 write_add_end_ += hop_;
             }
 
             if (write_add_end_ >= in.size()) {
-                // extract output
-                int extractSize = in.size();
-                for (int i = 0; i < extractSize; ++i) {
-                    in[i] = output_buffer_[i] / ((float)size_ / hop_);
-                }
-                
-                // shift output buffer
-                int shiftSize = write_end_ - extractSize;
-                for (int i = 0; i < shiftSize; i++) {
-                    output_buffer_[i] = output_buffer_[i + extractSize];
-                }
-                write_add_end_ -= extractSize;
-                int newWriteEnd = write_end_ - extractSize;
-                // zero shifed buffer
-                for (int i = newWriteEnd; i < write_end_; ++i) {
-                    output_buffer_[i] = 0.0f;
+                // 读出之后清零，下一圈可以直接累加
+                const float gain = static_cast<float>(hop_) / static_cast<float>(size_);
+                for (size_t i = 0; i < in.size(); ++i) {
+                    float& s = output_buffer_[(output_rpos_ + i) & output_mask_];
+                    in[i] = s * gain;
+                    s = 0.0f;
                 }
-                write_end_ = newWriteEnd;
+                output_rpos_ += in.size();
+                write_add_end_ -= in.size();
             }
             else {
                 // zero buffer
@@ -67,12 +66,14 @@ public:
 
     void SetSize(size_t size) noexcept {
         size_ = size;
-        if (input_buffer_.size() < size) {
-            input_buffer_.resize(size);
+        if (input_buffer_.size() < size * 2) {
+            input_buffer_.resize(size * 2);
         }
-        if (output_buffer_.size() < (size + hop_) * 2) {
-            output_buffer_.resize((size + hop_) * 2);
+        // 未读的采样加上一帧不会超过4倍的size，hop <= size
+        if (output_buffer_.size() < size * 4) {
+            output_buffer_.resize(std::bit_ceil(size * 4));
         }
+        output_mask_ = output_buffer_.size() - 1;
         process_buffer_.resize(size_);
     }
 
@@ -81,19 +82,27 @@ public:
     }
 
     void Reset() noexcept {
-        std::fill_n(output_buffer_.begin(), write_end_, 0.0f);
+        std::fill(input_buffer_.begin(), input_buffer_.end(), 0.0f);
+        std::fill(output_buffer_.begin(), output_buffer_.end(), 0.0f);
         input_wpos_ = 0;
-        write_end_ = 0;
+        input_rpos_ = 0;
+        output_rpos_ = 0;
         write_add_end_ = 0;
     }
 private:
+    // 镜像的环形缓冲，长度2 * size
     std::vector<float> input_buffer_;
     std::vector<float> process_buffer_;
+    // 2的幂的环形缓冲
     std::vector<float> output_buffer_;
+    size_t output_mask_{};
     size_t size_{};
     size_t hop_{};
+    // 当前帧已经有多少个采样
     size_t input_wpos_{};
-    size_t write_end_{};
+    size_t input_rpos_{};
+    size_t output_rpos_{};
+    // 从output_rpos_开始已经算完的采样数
     size_t write_add_end_{};
 };
 }
\ No newline at end of file
@@ -1,10 +1,15 @@
 #pragma once
+#include <algorithm>
+#include <array>
 #include <cmath>
 #include <cstddef>
+#include <memory>
 #include <span>
+#include <type_traits>
 #include <vector>
 #include <complex>
 #include <cassert>
+#include "qwqdsp/spectral/fft_plan.hpp"
 
 namespace qwqdsp::spectral {
 namespace internal {
@@ -18,9 +23,8 @@ namespace internal {
 // 0  1  2 ...... N/2 ............N-2 N-1
 // --------------------------------------------------------------------------------
 
-void cdft(int, int, float *, int *, float *) noexcept;
-void makewt(int nw, int *ip, float *w) noexcept;
-void makect(int nc, int *ip, float *c) noexcept;
+template<class T>
+void cdft(int, int, T *, int *, T *) noexcept;
 }
 
 /**
@@ -28,20 +32,40 @@ void makect(int nc, int *ip, float *c) noexcept;
  *           奈奎斯特     负频率        零            正频率
  *   true       0      1 ~ n/2-1      n/2        n/2+1 ~ n-1
  *   false     n/2     n/2+1 ~ n       0          1 ~ n/2-1
+ * @tparam T float或者double，double版本没有批处理，FFTBatch逐个处理
  */
-template<bool kUseNegPiFirst>
+template<bool kUseNegPiFirst, class T = float>
 class ComplexFFT {
 public:
-    void Init(size_t fft_size) {
+    /**
+     * @param fft_size 不是2的幂时使用kMixedRadix后端，kUseNegPiFirst = true时必须是偶数
+     * @param backend 计算后端，输出完全一致
+     */
+    void Init(size_t fft_size, FFTBackend backend = kDefaultFFTBackend) {
+        assert(!kUseNegPiFirst || fft_size % 2 == 0);
+        if (!internal::IsPowerOfTwo(fft_size)) {
+            backend = FFTBackend::kMixedRadix;
+        }
         fft_size_ = fft_size;
-        ip_.resize(2 + std::ceil(std::sqrt(fft_size / 2.0f)));
-        w_.resize(fft_size / 2);
+        backend_ = backend;
         buffer_.resize(fft_size * 2);
-        const size_t size4 = fft_size / 2;
-        internal::makewt(size4, ip_.data(), w_.data());
+        plan_ = FFTPlan<T>::Get(fft_size, FFTPlan<T>::Type::kComplex, backend);
+        simd_batch_work_.clear();
+        if (backend == FFTBackend::kMixedRadix) {
+            work_.resize(plan_->mixed.WorkSize());
+        }
+        else if (backend == FFTBackend::kSimd) {
+            work_.resize(fft_size * 4);
+            if (std::is_same_v<T, float> && fft_size <= internal::kSimdBatchMaxComplexSize) {
+                simd_batch_work_.resize(fft_size * 4 * internal::kSimdBatchLanes);
+            }
+        }
+        else {
+            ip_ = plan_->MakeOouraIp();
+        }
     }
     
-    void FFT(std::span<const float> time, std::span<std::complex<float>> spectral) noexcept {
+    void FFT(std::span<const T> time, std::span<std::complex<T>> spectral) noexcept {
         assert(time.size() == fft_size_);
         assert(spectral.size() == NumBins());
 
@@ -49,7 +73,7 @@ public:
             buffer_[2 * i] = time[i];
             buffer_[2 * i + 1] = 0.0f;
         }
-        internal::cdft(fft_size_ * 2, 1, buffer_.data(), ip_.data(), w_.data());
+        Cdft(1);
         if constexpr (kUseNegPiFirst) {
             for (size_t i = 0; i <= fft_size_ / 2; ++i) {
                 size_t e = fft_size_ / 2 - i;
@@ -73,7 +97,7 @@ public:
         }
     }
 
-    void FFT(std::span<const std::complex<float>> time, std::span<std::complex<float>> spectral) noexcept {
+    void FFT(std::span<const std::complex<T>> time, std::span<std::complex<T>> spectral) noexcept {
         assert(time.size() == fft_size_);
         assert(spectral.size() == NumBins());
 
@@ -81,7 +105,7 @@ public:
             buffer_[2 * i] = time[i].real();
             buffer_[2 * i + 1] = time[i].imag();
         }
-        internal::cdft(fft_size_ * 2, 1, buffer_.data(), ip_.data(), w_.data());
+        Cdft(1);
         if constexpr (kUseNegPiFirst) {
             for (size_t i = 0; i <= fft_size_ / 2; ++i) {
                 size_t e = fft_size_ / 2 - i;
@@ -105,7 +129,7 @@ public:
         }
     }
 
-    void FFT(std::span<const float> time, std::span<float> real, std::span<float> imag) noexcept {
+    void FFT(std::span<const T> time, std::span<T> real, std::span<T> imag) noexcept {
         assert(time.size() == fft_size_);
         assert(real.size() == NumBins());
         assert(imag.size() == NumBins());
@@ -114,7 +138,7 @@ public:
             buffer_[2 * i] = time[i];
             buffer_[2 * i + 1] = 0.0f;
         }
-        internal::cdft(fft_size_ * 2, 1, buffer_.data(), ip_.data(), w_.data());
+        Cdft(1);
         if constexpr (kUseNegPiFirst) {
             for (size_t i = 0; i <= fft_size_ / 2; ++i) {
                 size_t e = fft_size_ / 2 - i;
@@ -138,7 +162,7 @@ public:
         }
     }
 
-    void FFT(std::span<const std::complex<float>> time, std::span<float> real, std::span<float> imag) noexcept {
+    void FFT(std::span<const std::complex<T>> time, std::span<T> real, std::span<T> imag) noexcept {
         assert(time.size() == fft_size_);
         assert(real.size() == NumBins());
         assert(imag.size() == NumBins());
@@ -147,7 +171,7 @@ public:
             buffer_[2 * i] = time[i].real();
             buffer_[2 * i + 1] = time[i].imag();
         }
-        internal::cdft(fft_size_ * 2, 1, buffer_.data(), ip_.data(), w_.data());
+        Cdft(1);
         if constexpr (kUseNegPiFirst) {
             for (size_t i = 0; i <= fft_size_ / 2; ++i) {
                 size_t e = fft_size_ / 2 - i;
@@ -174,7 +198,7 @@ public:
     /**
      * @param phase 可选的，不需要请传入{}
      */
-    void FFTGainPhase(std::span<const float> time, std::span<float> gain, std::span<float> phase = {}) noexcept {
+    void FFTGainPhase(std::span<const T> time, std::span<T> gain, std::span<T> phase = {}) noexcept {
         assert(time.size() == fft_size_);
         assert(gain.size() == NumBins());
         if (!phase.empty()) {
@@ -185,34 +209,34 @@ public:
             buffer_[2 * i] = time[i];
             buffer_[2 * i + 1] = 0;
         }
-        internal::cdft(fft_size_ * 2, 1, buffer_.data(), ip_.data(), w_.data());
+        Cdft(1);
         if constexpr (kUseNegPiFirst) {
             for (size_t i = 0; i <= fft_size_ / 2; ++i) {
                 size_t e = fft_size_ / 2 - i;
-                float real = (buffer_[e * 2]);
-                float imag = (buffer_[e * 2 + 1]);
+                T real = (buffer_[e * 2]);
+                T imag = (buffer_[e * 2 + 1]);
                 gain[i] = std::sqrt(real * real + imag * imag);
                 if (!phase.empty()) phase[i] = std::atan2(imag, real);
             }
             for (size_t i = 0; i < fft_size_ / 2 - 1; ++i) {
                 size_t e = fft_size_ - 1 - i;
                 size_t a = fft_size_ / 2 + 1 + i;
-                float real = (buffer_[e * 2]);
-                float imag = (buffer_[e * 2 + 1]);
+                T real = (buffer_[e * 2]);
+                T imag = (buffer_[e * 2 + 1]);
                 gain[a] = std::sqrt(real * real + imag * imag);
                 if (!phase.empty()) phase[a] = std::atan2(imag, real);
             }
         }
         else {
             {
-                float real = (buffer_[0]);
-                float imag = (buffer_[1]);
+                T real = (buffer_[0]);
+                T imag = (buffer_[1]);
                 gain[0] = std::sqrt(real * real + imag * imag);
                 if (!phase.empty()) phase[0] = std::atan2(imag, real);
             }
             for (size_t i = 1; i < fft_size_; ++i) {
-                float real = (buffer_[i * 2]);
-                float imag = (buffer_[i * 2 + 1]);
+                T real = (buffer_[i * 2]);
+                T imag = (buffer_[i * 2 + 1]);
                 gain[fft_size_ - i] = std::sqrt(real * real + imag * imag);
                 if (!phase.empty()) phase[fft_size_ - i] = std::atan2(imag, real);
             }
@@ -220,7 +244,7 @@ public:
     }
 
     template<class SPAN_TYPE>
-    void IFFT(std::span<SPAN_TYPE> time, std::span<std::complex<float>> spectral) noexcept {
+    void IFFT(std::span<SPAN_TYPE> time, std::span<std::complex<T>> spectral) noexcept {
         if constexpr (kUseNegPiFirst) {
             for (size_t i = 0; i <= fft_size_ / 2; ++i) {
             size_t a = fft_size_ / 2 - i;
@@ -242,10 +266,10 @@ public:
                 buffer_[2 * i + 1] = spectral[fft_size_ - i].imag();
             }
         }
-        internal::cdft(fft_size_ * 2, -1, buffer_.data(), ip_.data(), w_.data());
-        const float gain = 1.0f / fft_size_;
+        Cdft(-1);
+        const T gain = T(1) / static_cast<T>(fft_size_);
         for (size_t i = 0; i < fft_size_; ++i) {
-            if constexpr (std::is_same_v<SPAN_TYPE, std::complex<float>>) {
+            if constexpr (std::is_same_v<SPAN_TYPE, std::complex<T>>) {
                 time[i].real(buffer_[i * 2] * gain);
                 time[i].imag(buffer_[i * 2 + 1] * gain);
             }
@@ -257,7 +281,7 @@ public:
 
 
     template<class SPAN_TYPE>
-    void IFFT(std::span<SPAN_TYPE> time, std::span<float> real, std::span<float> imag) noexcept {
+    void IFFT(std::span<SPAN_TYPE> time, std::span<T> real, std::span<T> imag) noexcept {
         if constexpr (kUseNegPiFirst) {
             for (size_t i = 0; i <= fft_size_ / 2; ++i) {
             size_t a = fft_size_ / 2 - i;
@@ -279,10 +303,10 @@ public:
                 buffer_[2 * i + 1] = imag[fft_size_ - i];
             }
         }
-        internal::cdft(fft_size_ * 2, -1, buffer_.data(), ip_.data(), w_.data());
-        const float gain = 1.0f / fft_size_;
+        Cdft(-1);
+        const T gain = T(1) / static_cast<T>(fft_size_);
         for (size_t i = 0; i < fft_size_; ++i) {
-            if constexpr (std::is_same_v<SPAN_TYPE, std::complex<float>>) {
+            if constexpr (std::is_same_v<SPAN_TYPE, std::complex<T>>) {
                 time[i].real(buffer_[i * 2] * gain);
                 time[i].imag(buffer_[i * 2 + 1] * gain);
             }
@@ -292,7 +316,7 @@ public:
         }
     }
 
-    void IFFTGainPhase(std::span<float> time, std::span<float> gain, std::span<float> phase) noexcept {
+    void IFFTGainPhase(std::span<T> time, std::span<T> gain, std::span<T> phase) noexcept {
         if constexpr (kUseNegPiFirst) {
             for (size_t i = 0; i <= fft_size_ / 2; ++i) {
             size_t a = fft_size_ / 2 - i;
@@ -314,14 +338,14 @@ public:
                 buffer_[2 * i + 1] = gain[fft_size_ - i] * std::sin(phase[fft_size_ - i]);
             }
         }
-        internal::cdft(fft_size_ * 2, -1, buffer_.data(), ip_.data(), w_.data());
-        const float g = 1.0f / fft_size_;
+        Cdft(-1);
+        const T g = T(1) / static_cast<T>(fft_size_);
         for (size_t i = 0; i < fft_size_; ++i) {
             time[i] = buffer_[i * 2] * g;
         }
     }
 
-    void IFFTGainPhase(std::span<std::complex<float>> time, std::span<float> gain, std::span<float> phase) noexcept {
+    void IFFTGainPhase(std::span<std::complex<T>> time, std::span<T> gain, std::span<T> phase) noexcept {
         if constexpr (kUseNegPiFirst) {
             for (size_t i = 0; i <= fft_size_ / 2; ++i) {
             size_t a = fft_size_ / 2 - i;
@@ -343,15 +367,15 @@ public:
                 buffer_[2 * i + 1] = gain[fft_size_ - i] * std::sin(phase[fft_size_ - i]);
             }
         }
-        internal::cdft(fft_size_ * 2, -1, buffer_.data(), ip_.data(), w_.data());
-        const float g = 1.0f / fft_size_;
+        Cdft(-1);
+        const T g = T(1) / static_cast<T>(fft_size_);
         for (size_t i = 0; i < fft_size_; ++i) {
             time[i].real(buffer_[i * 2] * g);
             time[i].imag(buffer_[i * 2 + 1] * g);
         }
     }
 
-    void Hilbert(std::span<const float> time, std::span<std::complex<float>> output, bool clear_dc) noexcept {
+    void Hilbert(std::span<const T> time, std::span<std::complex<T>> output, bool clear_dc) noexcept {
         assert(time.size() == fft_size_);
         assert(output.size() == fft_size_);
 
@@ -359,7 +383,7 @@ public:
             buffer_[2 * i] = time[i];
             buffer_[2 * i + 1] = 0.0f;
         }
-        internal::cdft(fft_size_ * 2, 1, buffer_.data(), ip_.data(), w_.data());
+        Cdft(1);
         if (clear_dc) {
             // Z[0] = X[0]
             buffer_[0] = 0.0f;
@@ -381,16 +405,16 @@ public:
             buffer_[2 * i] = 0.0f;
             buffer_[2 * i + 1] = 0.0f;
         }
-        internal::cdft(fft_size_ * 2, -1, buffer_.data(), ip_.data(), w_.data());
+        Cdft(-1);
         // Z[n] = 2 * X[n]
-        const float gain = 2.0f / fft_size_;
+        const T gain = T(2) / static_cast<T>(fft_size_);
         for (size_t i = 0; i < fft_size_; ++i) {
             output[i].real(buffer_[i * 2] * gain);
             output[i].imag(buffer_[i * 2 + 1] * gain);
         }
     }
 
-    void Hilbert(std::span<const float> time, std::span<float> real, std::span<float> imag) noexcept {
+    void Hilbert(std::span<const T> time, std::span<T> real, std::span<T> imag) noexcept {
         assert(time.size() == fft_size_);
         assert(real.size() == fft_size_);
         assert(imag.size() == fft_size_);
@@ -399,7 +423,7 @@ public:
             buffer_[2 * i] = time[i];
             buffer_[2 * i + 1] = 0.0f;
         }
-        internal::cdft(fft_size_ * 2, 1, buffer_.data(), ip_.data(), w_.data());
+        Cdft(1);
         // Z[0] = X[0]
         buffer_[0] *= 0.5f;
         buffer_[1] *= 0.5f;
@@ -411,16 +435,16 @@ public:
             buffer_[2 * i] = 0.0f;
             buffer_[2 * i + 1] = 0.0f;
         }
-        internal::cdft(fft_size_ * 2, -1, buffer_.data(), ip_.data(), w_.data());
+        Cdft(-1);
         // Z[n] = 2 * X[n]
-        const float gain = 2.0f / fft_size_;
+        const T gain = T(2) / static_cast<T>(fft_size_);
         for (size_t i = 0; i < fft_size_; ++i) {
             real[i] = buffer_[i * 2] * gain;
             imag[i] = buffer_[i * 2 + 1] * gain;
         }
     }
 
-    void Hilbert(std::span<const float> input, std::span<float> output90, bool clear_dc) noexcept {
+    void Hilbert(std::span<const T> input, std::span<T> output90, bool clear_dc) noexcept {
         assert(input.size() == fft_size_);
         assert(output90.size() == fft_size_);
 
@@ -428,7 +452,7 @@ public:
             buffer_[2 * i] = input[i];
             buffer_[2 * i + 1] = 0.0f;
         }
-        internal::cdft(fft_size_ * 2, 1, buffer_.data(), ip_.data(), w_.data());
+        Cdft(1);
         if (clear_dc) {
             // Z[0] = X[0]
             buffer_[0] = 0.0f;
@@ -439,25 +463,157 @@ public:
         }
         // Z[negative frequency] -> -b + ai
         for (size_t i = 1; i < fft_size_ / 2; ++i) {
-            float re = buffer_[2 * i];
-            float im = buffer_[2 * i + 1];
+            T re = buffer_[2 * i];
+            T im = buffer_[2 * i + 1];
             buffer_[2 * i] = -im;
             buffer_[2 * i + 1] = re;
         }
         // Z[n] -> b - ai
         for (size_t i = fft_size_ / 2 + 1; i < fft_size_; ++i) {
-            float re = buffer_[2 * i];
-            float im = buffer_[2 * i + 1];
+            T re = buffer_[2 * i];
+            T im = buffer_[2 * i + 1];
             buffer_[2 * i] = im;
             buffer_[2 * i + 1] = -re;
         }
-        internal::cdft(fft_size_ * 2, -1, buffer_.data(), ip_.data(), w_.data());
-        const float gain = 1.0f / fft_size_;
+        Cdft(-1);
+        const T gain = T(1) / static_cast<T>(fft_size_);
         for (size_t i = 0; i < fft_size_; ++i) {
             output90[i] = buffer_[i * 2] * gain;
         }
     }
 
+    /**
+     * @brief 一次对多个通道做FFT，频谱排列和FFT相同
+     *        第c个通道的时域从time[c * time_stride]开始，频谱写入spectral[c * spectral_stride]开始的NumBins()个点
+     *        simd后端把kSimdBatchLanes个通道交错在一起计算，每一级蝴蝶都在通道方向向量化
+     */
+    void FFTBatch(
+        std::span<const std::complex<T>> time, size_t time_stride,
+        std::span<std::complex<T>> spectral, size_t spectral_stride,
+        size_t count
+    ) noexcept {
+        assert(time_stride >= fft_size_);
+        assert(spectral_stride >= fft_size_);
+        assert(count == 0 || time.size() >= (count - 1) * time_stride + fft_size_);
+        assert(count == 0 || spectral.size() >= (count - 1) * spectral_stride + fft_size_);
+
+        if (simd_batch_work_.empty()) {
+            for (size_t c = 0; c < count; ++c) {
+                FFT(time.subspan(c * time_stride, fft_size_), spectral.subspan(c * spectral_stride, fft_size_));
+            }
+            return;
+        }
+
+        const size_t rotate = kUseNegPiFirst ? fft_size_ / 2 : 0;
+        if constexpr (std::is_same_v<T, float>) {
+            std::array<const float*, internal::kSimdBatchLanes> in;
+            std::array<float*, internal::kSimdBatchLanes> out;
+            for (size_t begin = 0; begin < count; begin += internal::kSimdBatchLanes) {
+                const size_t num = std::min(internal::kSimdBatchLanes, count - begin);
+                for (size_t c = 0; c < num; ++c) {
+                    in[c] = reinterpret_cast<const float*>(time.data() + (begin + c) * time_stride);
+                    out[c] = reinterpret_cast<float*>(spectral.data() + (begin + c) * spectral_stride);
+                }
+                internal::simd_cdft_batch(fft_size_, false, num, in.data(), out.data(), 0, rotate, 1.0f, plan_->simd, simd_batch_work_.data());
+            }
+        }
+    }
+
+    /**
+     * @brief FFTBatch的逆变换
+     */
+    void IFFTBatch(
+        std::span<std::complex<T>> time, size_t time_stride,
+        std::span<const std::complex<T>> spectral, size_t spectral_stride,
+        size_t count
+    ) noexcept {
+        assert(time_stride >= fft_size_);
+        assert(spectral_stride >= fft_size_);
+        assert(count == 0 || time.size() >= (count - 1) * time_stride + fft_size_);
+        assert(count == 0 || spectral.size() >= (count - 1) * spectral_stride + fft_size_);
+
+        const size_t rotate = kUseNegPiFirst ? fft_size_ / 2 : 0;
+        if (simd_batch_work_.empty()) {
+            const T gain = T(1) / static_cast<T>(fft_size_);
+            for (size_t c = 0; c < count; ++c) {
+                const std::complex<T>* in = spectral.data() + c * spectral_stride;
+                for (size_t i = 0; i < fft_size_; ++i) {
+                    auto const& v = in[((fft_size_ - i) % fft_size_ + rotate) % fft_size_];
+                    buffer_[2 * i] = v.real();
+                    buffer_[2 * i + 1] = v.imag();
+                }
+                Cdft(-1);
+                std::complex<T>* out = time.data() + c * time_stride;
+                for (size_t i = 0; i < fft_size_; ++i) {
+                    out[i].real(buffer_[2 * i] * gain);
+                    out[i].imag(buffer_[2 * i + 1] * gain);
+                }
+            }
+            return;
+        }
+
+        if constexpr (std::is_same_v<T, float>) {
+            std::array<const float*, internal::kSimdBatchLanes> in;
+            std::array<float*, internal::kSimdBatchLanes> out;
+            for (size_t begin = 0; begin < count; begin += internal::kSimdBatchLanes) {
+                const size_t num = std::min(internal::kSimdBatchLanes, count - begin);
+                for (size_t c = 0; c < num; ++c) {
+                    in[c] = reinterpret_cast<const float*>(spectral.data() + (begin + c) * spectral_stride);
+                    out[c] = reinterpret_cast<float*>(time.data() + (begin + c) * time_stride);
+                }
+                internal::simd_cdft_batch(fft_size_, true, num, in.data(), out.data(), rotate, 0, 1.0f / fft_size_, plan_->simd, simd_batch_work_.data());
+            }
+        }
+    }
+
+    /**
+     * @brief 直接在block上变换，不经过内部缓冲也不重排
+     *        输出固定为标准DFT的0 ~ 2pi排列(oouras的isgn = -1)，和kUseNegPiFirst无关
+     *        用GetPackedBin/SetPackedBin可以按本类的排列访问
+     */
+    void FFTInplace(std::span<std::complex<T>> block) noexcept {
+        assert(block.size() == fft_size_);
+        Cdft(-1, reinterpret_cast<T*>(block.data()));
+    }
+
+    /**
+     * @brief FFTInplace的逆变换
+     * @param normalize false: 不乘以1/N，输出为N倍，增益可以提前合并进频谱里省去一次遍历
+     */
+    void IFFTInplace(std::span<std::complex<T>> block, bool normalize = true) noexcept {
+        assert(block.size() == fft_size_);
+        Cdft(1, reinterpret_cast<T*>(block.data()));
+        if (normalize) {
+            const T gain = T(1) / static_cast<T>(fft_size_);
+            for (auto& s : block) {
+                s *= gain;
+            }
+        }
+    }
+
+    /**
+     * @brief 本类排列的第i个bin在FFTInplace输出中的位置
+     */
+    static constexpr size_t PackedIndex(size_t fft_size, size_t i) noexcept {
+        if constexpr (kUseNegPiFirst) {
+            return (i + fft_size / 2) % fft_size;
+        }
+        else {
+            return i;
+        }
+    }
+
+    /**
+     * @brief 按本类的排列读取FFTInplace输出的第i个bin
+     */
+    static std::complex<T> GetPackedBin(std::span<const std::complex<T>> packed, size_t i) noexcept {
+        return packed[PackedIndex(packed.size(), i)];
+    }
+
+    static void SetPackedBin(std::span<std::complex<T>> packed, size_t i, std::complex<T> bin) noexcept {
+        packed[PackedIndex(packed.size(), i)] = bin;
+    }
+
     /**
      * @brief 0 ~ N ---> -N/2 ~ N/2
      */
@@ -486,12 +642,39 @@ public:
     float FFTSizeFloat() const noexcept {
         return static_cast<float>(fft_size_);
     }
+
+    FFTBackend Backend() const noexcept {
+        return backend_;
+    }
 private:
     friend struct ComplexFFTHelper;
 
+    void Cdft(int isgn) noexcept {
+        Cdft(isgn, buffer_.data());
+    }
+
+    void Cdft(int isgn, T* a) noexcept {
+        if (backend_ == FFTBackend::kSimd) {
+            internal::simd_cdft(fft_size_ * 2, isgn, a, plan_->simd, work_.data());
+        }
+        else if (backend_ == FFTBackend::kMixedRadix) {
+            internal::mixed_cdft(fft_size_ * 2, isgn, a, plan_->mixed, work_.data());
+        }
+        else {
+            // ip[0]和ip[1]已经填好，cdft只读w
+            internal::cdft(fft_size_ * 2, isgn, a, ip_.data(), const_cast<T*>(plan_->ooura_w.data()));
+        }
+    }
+
     size_t fft_size_{};
+    FFTBackend backend_{};
+    // 旋转因子表是共享的，其余都是实例自己的工作区
+    std::shared_ptr<const FFTPlan<T>> plan_;
     std::vector<int> ip_;
-    std::vector<float> w_;
-    std::vector<float> buffer_;
+    std::vector<T> buffer_;
+    // 计算后端的工作区
+    std::vector<T> work_;
+    // 只有simd后端并且点数不超过kSimdBatchMaxComplexSize时才分配，否则Batch逐个处理
+    std::vector<T> simd_batch_work_;
 };
 }
\ No newline at end of file
@@ -0,0 +1,172 @@
+#pragma once
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <memory>
+#include <span>
+#include <vector>
+#include "qwqdsp/spectral/fft_plan.hpp"
+
+namespace qwqdsp::spectral {
+namespace internal {
+template<class T>
+void ddct(int, int, T *, int *, T *) noexcept;
+template<class T>
+void ddst(int, int, T *, int *, T *) noexcept;
+template<class T>
+void dfct(int, T *, T *, int *, T *) noexcept;
+template<class T>
+void dfst(int, T *, T *, int *, T *) noexcept;
+}
+
+/**
+ * @brief oouras的DCT/DST，旋转因子表和RealFFT一样通过FFTPlan共享，缓冲区是实例自己的
+ *        正变换都不带归一化，IDCT2/IDST2是对应的精确逆变换
+ *        正交归一化的DCT-II(MFCC常用)为 X[0] * sqrt(1/N), X[k] * sqrt(2/N)
+ * @tparam T float或者double
+ */
+template<class T = float>
+class DCT {
+public:
+    /**
+     * @param size N，2的幂，>= 8
+     */
+    void Init(size_t size) {
+        assert(internal::IsPowerOfTwo(size));
+        assert(size >= 8);
+        size_ = size;
+        plan_ = FFTPlan<T>::Get(size, FFTPlan<T>::Type::kDCT, FFTBackend::kOoura);
+        plan1_ = FFTPlan<T>::Get(size, FFTPlan<T>::Type::kDCTI, FFTBackend::kOoura);
+        ip_ = plan_->MakeOouraIp();
+        ip1_ = plan1_->MakeOouraIp();
+        buffer_.resize(size + 1);
+        work_.resize(size / 2 + 1);
+    }
+
+    /**
+     * @brief DCT-II: X[k] = sum_{n=0}^{N-1} x[n] * cos(pi/N * (n + 0.5) * k)
+     * @note input和output可以是同一块内存，下同
+     */
+    void DCT2(std::span<const T> input, std::span<T> output) noexcept {
+        assert(input.size() == size_);
+        assert(output.size() == size_);
+        std::copy(input.begin(), input.end(), buffer_.begin());
+        Ddct(-1);
+        std::copy_n(buffer_.begin(), size_, output.begin());
+    }
+
+    /**
+     * @brief DCT-III: x[n] = sum_{k=0}^{N-1} X[k] * cos(pi/N * k * (n + 0.5))，X[0]没有减半
+     */
+    void DCT3(std::span<const T> input, std::span<T> output) noexcept {
+        assert(input.size() == size_);
+        assert(output.size() == size_);
+        std::copy(input.begin(), input.end(), buffer_.begin());
+        Ddct(1);
+        std::copy_n(buffer_.begin(), size_, output.begin());
+    }
+
+    /**
+     * @brief DCT2的逆变换
+     */
+    void IDCT2(std::span<const T> input, std::span<T> output) noexcept {
+        assert(input.size() == size_);
+        assert(output.size() == size_);
+        std::copy(input.begin(), input.end(), buffer_.begin());
+        buffer_[0] *= T(0.5);
+        Ddct(1);
+        const T gain = T(2) / static_cast<T>(size_);
+        for (size_t i = 0; i < size_; ++i) {
+            output[i] = buffer_[i] * gain;
+        }
+    }
+
+    /**
+     * @brief DST-II: X[k] = sum_{n=0}^{N-1} x[n] * sin(pi/N * (n + 0.5) * (k + 1))
+     */
+    void DST2(std::span<const T> input, std::span<T> output) noexcept {
+        assert(input.size() == size_);
+        assert(output.size() == size_);
+        std::copy(input.begin(), input.end(), buffer_.begin());
+        Ddst(-1);
+        // oouras: a[k] = X[k-1], a[0] = X[N-1]
+        std::copy_n(buffer_.begin() + 1, size_ - 1, output.begin());
+        output[size_ - 1] = buffer_[0];
+    }
+
+    /**
+     * @brief DST-III: x[n] = sum_{k=0}^{N-1} X[k] * sin(pi/N * (k + 1) * (n + 0.5))，X[N-1]没有减半
+     */
+    void DST3(std::span<const T> input, std::span<T> output) noexcept {
+        assert(input.size() == size_);
+        assert(output.size() == size_);
+        buffer_[0] = input[size_ - 1];
+        std::copy_n(input.begin(), size_ - 1, buffer_.begin() + 1);
+        Ddst(1);
+        std::copy_n(buffer_.begin(), size_, output.begin());
+    }
+
+    /**
+     * @brief DST2的逆变换
+     */
+    void IDST2(std::span<const T> input, std::span<T> output) noexcept {
+        assert(input.size() == size_);
+        assert(output.size() == size_);
+        buffer_[0] = input[size_ - 1] * T(0.5);
+        std::copy_n(input.begin(), size_ - 1, buffer_.begin() + 1);
+        Ddst(1);
+        const T gain = T(2) / static_cast<T>(size_);
+        for (size_t i = 0; i < size_; ++i) {
+            output[i] = buffer_[i] * gain;
+        }
+    }
+
+    /**
+     * @brief DCT-I: X[k] = sum_{n=0}^{N} x[n] * cos(pi/N * n * k)，N+1个点
+     *        逆变换为 x[0]和x[N]减半之后再做一次DCT1，乘以2/N
+     */
+    void DCT1(std::span<const T> input, std::span<T> output) noexcept {
+        assert(input.size() == size_ + 1);
+        assert(output.size() == size_ + 1);
+        std::copy(input.begin(), input.end(), buffer_.begin());
+        internal::dfct(static_cast<int>(size_), buffer_.data(), work_.data(), ip1_.data(), const_cast<T*>(plan1_->ooura_w.data()));
+        std::copy_n(buffer_.begin(), size_ + 1, output.begin());
+    }
+
+    /**
+     * @brief DST-I: X[k] = sum_{n=1}^{N-1} x[n-1] * sin(pi/N * n * (k + 1))，N-1个点
+     *        逆变换为再做一次DST1，乘以2/N
+     */
+    void DST1(std::span<const T> input, std::span<T> output) noexcept {
+        assert(input.size() == size_ - 1);
+        assert(output.size() == size_ - 1);
+        buffer_[0] = 0;
+        std::copy(input.begin(), input.end(), buffer_.begin() + 1);
+        internal::dfst(static_cast<int>(size_), buffer_.data(), work_.data(), ip1_.data(), const_cast<T*>(plan1_->ooura_w.data()));
+        std::copy_n(buffer_.begin() + 1, size_ - 1, output.begin());
+    }
+
+    size_t Size() const noexcept {
+        return size_;
+    }
+private:
+    void Ddct(int isgn) noexcept {
+        // ip[0]和ip[1]已经填好，ddct只读w
+        internal::ddct(static_cast<int>(size_), isgn, buffer_.data(), ip_.data(), const_cast<T*>(plan_->ooura_w.data()));
+    }
+
+    void Ddst(int isgn) noexcept {
+        internal::ddst(static_cast<int>(size_), isgn, buffer_.data(), ip_.data(), const_cast<T*>(plan_->ooura_w.data()));
+    }
+
+    size_t size_{};
+    // ddct/ddst和dfct/dfst的表大小不同，各自一份
+    std::shared_ptr<const FFTPlan<T>> plan_;
+    std::shared_ptr<const FFTPlan<T>> plan1_;
+    std::vector<int> ip_;
+    std::vector<int> ip1_;
+    std::vector<T> buffer_;
+    // dfct/dfst的工作区
+    std::vector<T> work_;
+};
+}
\ No newline at end of file
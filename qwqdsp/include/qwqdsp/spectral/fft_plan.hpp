@@ -0,0 +1,49 @@
+#pragma once
+#include <cstddef>
+#include <memory>
+#include <vector>
+#include "qwqdsp/spectral/simd_fft.hpp"
+
+namespace qwqdsp::spectral {
+/**
+ * @brief 只读的FFT旋转因子表，点数、类型、后端都相同的FFT共享同一份
+ *        oouras的ip在每次变换时会被bitrv2当作工作区写入，不能共享，由实例通过MakeOouraIp自己持有
+ * @tparam T float或者double
+ */
+template<class T>
+struct FFTPlan {
+    enum class Type {
+        kReal,
+        kComplex,
+        // ddct/ddst，只有oouras后端
+        kDCT,
+        // dfct/dfst，只有oouras后端
+        kDCTI
+    };
+
+    size_t fft_size{};
+    Type type{};
+    FFTBackend backend{};
+    // oouras: makewt/makect的输出
+    std::vector<T> ooura_w;
+    int ooura_nw{};
+    int ooura_nc{};
+    // simd
+    internal::SimdFFTTable<T> simd;
+    // mixed radix
+    internal::MixedFFTTable<T> mixed;
+
+    /**
+     * @brief 线程安全，缓存中只保存weak_ptr，所有使用者释放后表也跟着释放
+     */
+    static std::shared_ptr<const FFTPlan> Get(size_t fft_size, Type type, FFTBackend backend);
+
+    /**
+     * @brief 实例自己的ip，ip[0]和ip[1]已经填好，rdft/cdft不会再去写ooura_w
+     */
+    std::vector<int> MakeOouraIp() const;
+};
+
+extern template struct FFTPlan<float>;
+extern template struct FFTPlan<double>;
+}
\ No newline at end of file
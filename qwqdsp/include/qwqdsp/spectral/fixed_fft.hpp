@@ -0,0 +1,455 @@
+#pragma once
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <complex>
+#include <cstddef>
+#include <span>
+#include <type_traits>
+#include "qwqdsp/spectral/simd_ops.hpp"
+#include "qwqdsp/spectral/split_spectrum.hpp"
+
+namespace qwqdsp::spectral {
+namespace internal {
+/**
+ * @brief 编译期计算cos(2pi*k/n)和sin(2pi*k/n)，double精度
+ *        polymath里的近似不够准，这里先归约到[-pi/4, pi/4]再用泰勒级数
+ */
+constexpr void FixedSinCos(size_t k, size_t n, double& c, double& s) noexcept {
+    constexpr double kPi = 3.14159265358979323846;
+    k %= n;
+    // 最近的象限，余下的角度 = pi/2 * (4k - quadrant*n) / n
+    size_t const quadrant = (4 * k + n / 2) / n;
+    double const num = static_cast<double>(4 * k) - static_cast<double>(quadrant * n);
+    double const r = kPi / 2 * num / static_cast<double>(n);
+    double const r2 = r * r;
+    double sr = r;
+    double cr = 1.0;
+    double term_s = r;
+    double term_c = 1.0;
+    for (int i = 1; i < 12; ++i) {
+        term_s *= -r2 / static_cast<double>((2 * i) * (2 * i + 1));
+        term_c *= -r2 / static_cast<double>((2 * i - 1) * (2 * i));
+        sr += term_s;
+        cr += term_c;
+    }
+    switch (quadrant & 3) {
+    case 0:
+        c = cr;
+        s = sr;
+        break;
+    case 1:
+        c = -sr;
+        s = cr;
+        break;
+    case 2:
+        c = -cr;
+        s = -sr;
+        break;
+    default:
+        c = sr;
+        s = -cr;
+        break;
+    }
+}
+
+/**
+ * @brief N点复数FFT，split格式的radix-4 Stockham，每一级的长度和步长都是模板参数
+ *        旋转因子的排列和SimdFFTTable一致: 每个radix-4级依次存放k = 1..3的wr[m]和wi[m]
+ */
+template<size_t N, class T>
+struct FixedStockham {
+    static_assert(N >= 2 && (N & (N - 1)) == 0, "N必须是2的幂");
+
+    static constexpr size_t NumStages() noexcept {
+        size_t count = 0;
+        for (size_t len = N; len > 1; len /= 4) {
+            ++count;
+        }
+        return count;
+    }
+
+    // 偶数级之后结果回到x
+    static constexpr bool kResultInY = NumStages() % 2 == 1;
+
+    static constexpr size_t TwiddleOffset(size_t stage_len) noexcept {
+        size_t offset = 0;
+        for (size_t len = N; len > stage_len; len /= 4) {
+            offset += len / 4 * 6;
+        }
+        return offset;
+    }
+
+    static constexpr size_t kTwiddleSize = TwiddleOffset(1) == 0 ? 1 : TwiddleOffset(1);
+
+    static constexpr std::array<T, kTwiddleSize> MakeTwiddle() noexcept {
+        std::array<T, kTwiddleSize> table{};
+        size_t pos = 0;
+        for (size_t len = N; len >= 4; len /= 4) {
+            const size_t m = len / 4;
+            for (size_t k = 1; k < 4; ++k) {
+                for (size_t p = 0; p < m; ++p) {
+                    double c = 0;
+                    double s = 0;
+                    FixedSinCos(p * k, len, c, s);
+                    table[pos + p] = static_cast<T>(c);
+                    table[pos + m + p] = static_cast<T>(-s);
+                }
+                pos += 2 * m;
+            }
+        }
+        return table;
+    }
+
+    static constexpr std::array<T, kTwiddleSize> kTwiddle = MakeTwiddle();
+
+    /**
+     * @brief 不缩放，kInverse为exp(+i)
+     * @return true: 结果在yr/yi，false: 结果在xr/xi，和kResultInY一致
+     */
+    template<bool kInverse>
+    static bool Transform(T* xr, T* xi, T* yr, T* yi) noexcept {
+        Stages<kInverse, N, 1>(xr, xi, yr, yi);
+        return kResultInY;
+    }
+
+private:
+    template<bool kInverse, size_t kLen, size_t kStride>
+    static void Stages(T* xr, T* xi, T* yr, T* yi) noexcept {
+        if constexpr (kLen == 2) {
+            Radix2<kStride>(xr, xi, yr, yi);
+        }
+        else if constexpr (kLen >= 4) {
+            Radix4<kInverse, kLen, kStride>(xr, xi, yr, yi);
+            Stages<kInverse, kLen / 4, kStride * 4>(yr, yi, xr, xi);
+        }
+    }
+
+    template<size_t kStride>
+    static void Radix2(const T* xr, const T* xi, T* yr, T* yi) noexcept {
+#ifdef QWQDSP_FFT_HAS_AVX
+        if constexpr (kStride % AvxOps<T>::kWidth == 0) {
+            Radix2Strided<AvxOps<T>, kStride>(xr, xi, yr, yi);
+            return;
+        }
+#endif
+#ifdef QWQDSP_FFT_HAS_SSE
+        if constexpr (kStride % SseOps<T>::kWidth == 0) {
+            Radix2Strided<SseOps<T>, kStride>(xr, xi, yr, yi);
+            return;
+        }
+#endif
+        Radix2Strided<ScalarOps<T>, kStride>(xr, xi, yr, yi);
+    }
+
+    template<bool kInverse, size_t kLen, size_t kStride>
+    static void Radix4(const T* xr, const T* xi, T* yr, T* yi) noexcept {
+#ifdef QWQDSP_FFT_HAS_AVX
+        if constexpr (kStride % AvxOps<T>::kWidth == 0) {
+            Radix4Strided<AvxOps<T>, kInverse, kLen, kStride>(xr, xi, yr, yi);
+            return;
+        }
+        // float的AVX宽度为8，第一级仍然用SSE
+        if constexpr (std::is_same_v<T, double> && kStride == 1 && kLen % (4 * AvxOps<T>::kWidth) == 0) {
+            Radix4First<AvxOps<T>, kInverse, kLen>(xr, xi, yr, yi);
+            return;
+        }
+#endif
+#ifdef QWQDSP_FFT_HAS_SSE
+        if constexpr (kStride % SseOps<T>::kWidth == 0) {
+            Radix4Strided<SseOps<T>, kInverse, kLen, kStride>(xr, xi, yr, yi);
+            return;
+        }
+        if constexpr (kStride == 1 && kLen % (4 * SseOps<T>::kWidth) == 0) {
+            Radix4First<SseOps<T>, kInverse, kLen>(xr, xi, yr, yi);
+            return;
+        }
+#endif
+        Radix4Strided<ScalarOps<T>, kInverse, kLen, kStride>(xr, xi, yr, yi);
+    }
+
+    template<class Ops, size_t kStride>
+    static void Radix2Strided(const T* xr, const T* xi, T* yr, T* yi) noexcept {
+        for (size_t q = 0; q < kStride; q += Ops::kWidth) {
+            auto const ar = Ops::Load(xr + q);
+            auto const ai = Ops::Load(xi + q);
+            auto const br = Ops::Load(xr + kStride + q);
+            auto const bi = Ops::Load(xi + kStride + q);
+            Ops::Store(yr + q, Ops::Add(ar, br));
+            Ops::Store(yi + q, Ops::Add(ai, bi));
+            Ops::Store(yr + kStride + q, Ops::Sub(ar, br));
+            Ops::Store(yi + kStride + q, Ops::Sub(ai, bi));
+        }
+    }
+
+    /**
+     * @brief 和simd_fft.cpp的Radix4Strided相同，len和s是常量，旋转因子可以直接折叠进指令
+     */
+    template<class Ops, bool kInverse, size_t kLen, size_t kStride>
+    static void Radix4Strided(const T* xr, const T* xi, T* yr, T* yi) noexcept {
+        using V = typename Ops::V;
+        constexpr size_t m = kLen / 4;
+        constexpr size_t s = kStride;
+        constexpr size_t offset = TwiddleOffset(kLen);
+        for (size_t p = 0; p < m; ++p) {
+            V const w[6]{
+                Ops::Set1(kTwiddle[offset + p]), Ops::Set1(kTwiddle[offset + m + p]),
+                Ops::Set1(kTwiddle[offset + 2 * m + p]), Ops::Set1(kTwiddle[offset + 3 * m + p]),
+                Ops::Set1(kTwiddle[offset + 4 * m + p]), Ops::Set1(kTwiddle[offset + 5 * m + p])
+            };
+            for (size_t q = 0; q < s; q += Ops::kWidth) {
+                const size_t x0 = s * p + q;
+                Cpx<Ops> const a{Ops::Load(xr + x0), Ops::Load(xi + x0)};
+                Cpx<Ops> const b{Ops::Load(xr + x0 + s * m), Ops::Load(xi + x0 + s * m)};
+                Cpx<Ops> const c{Ops::Load(xr + x0 + 2 * s * m), Ops::Load(xi + x0 + 2 * s * m)};
+                Cpx<Ops> const d{Ops::Load(xr + x0 + 3 * s * m), Ops::Load(xi + x0 + 3 * s * m)};
+                Cpx<Ops> o0, o1, o2, o3;
+                Butterfly4<Ops, kInverse>(a, b, c, d, w, o0, o1, o2, o3);
+                const size_t y0 = s * 4 * p + q;
+                Ops::Store(yr + y0, o0.re);
+                Ops::Store(yi + y0, o0.im);
+                Ops::Store(yr + y0 + s, o1.re);
+                Ops::Store(yi + y0 + s, o1.im);
+                Ops::Store(yr + y0 + 2 * s, o2.re);
+                Ops::Store(yi + y0 + 2 * s, o2.im);
+                Ops::Store(yr + y0 + 3 * s, o3.re);
+                Ops::Store(yi + y0 + 3 * s, o3.im);
+            }
+        }
+    }
+
+    template<class Ops, bool kInverse, size_t kLen>
+    static void Radix4First(const T* xr, const T* xi, T* yr, T* yi) noexcept {
+        using V = typename Ops::V;
+        constexpr size_t m = kLen / 4;
+        const T* tw = kTwiddle.data();
+        for (size_t p = 0; p < m; p += Ops::kWidth) {
+            V const w[6]{
+                Ops::Load(tw + p), Ops::Load(tw + m + p),
+                Ops::Load(tw + 2 * m + p), Ops::Load(tw + 3 * m + p),
+                Ops::Load(tw + 4 * m + p), Ops::Load(tw + 5 * m + p)
+            };
+            Cpx<Ops> const a{Ops::Load(xr + p), Ops::Load(xi + p)};
+            Cpx<Ops> const b{Ops::Load(xr + p + m), Ops::Load(xi + p + m)};
+            Cpx<Ops> const c{Ops::Load(xr + p + 2 * m), Ops::Load(xi + p + 2 * m)};
+            Cpx<Ops> const d{Ops::Load(xr + p + 3 * m), Ops::Load(xi + p + 3 * m)};
+            Cpx<Ops> o0, o1, o2, o3;
+            Butterfly4<Ops, kInverse>(a, b, c, d, w, o0, o1, o2, o3);
+            Ops::StoreTransposed4(yr + 4 * p, o0.re, o1.re, o2.re, o3.re);
+            Ops::StoreTransposed4(yi + 4 * p, o0.im, o1.im, o2.im, o3.im);
+        }
+    }
+};
+}
+
+/**
+ * @brief 编译期固定点数的复数FFT，旋转因子在编译期生成，构造不分配内存
+ *        每一级的长度和步长都是常量，小点数时编译器可以把整个变换展开
+ *        输出为标准DFT的0 ~ 2pi排列，和ComplexFFT<false>一致
+ * @tparam N 2的幂
+ * @tparam T float或者double
+ */
+template<size_t N, class T = float>
+class ComplexFFTFixed {
+public:
+    using Kernel = internal::FixedStockham<N, T>;
+
+    void FFT(std::span<const std::complex<T>> time, std::span<std::complex<T>> spectral) noexcept {
+        assert(time.size() == N);
+        assert(spectral.size() == N);
+        Run<false>(reinterpret_cast<const T*>(time.data()), reinterpret_cast<T*>(spectral.data()));
+    }
+
+    void FFT(std::span<const T> time, std::span<std::complex<T>> spectral) noexcept {
+        assert(time.size() == N);
+        assert(spectral.size() == N);
+        std::copy(time.begin(), time.end(), xr_.begin());
+        xi_.fill(T{});
+        Finish<false>(reinterpret_cast<T*>(spectral.data()));
+    }
+
+    /**
+     * @brief 乘以1/N
+     */
+    void IFFT(std::span<std::complex<T>> time, std::span<const std::complex<T>> spectral) noexcept {
+        assert(time.size() == N);
+        assert(spectral.size() == N);
+        Run<true>(reinterpret_cast<const T*>(spectral.data()), reinterpret_cast<T*>(time.data()));
+        Normalize(time);
+    }
+
+    /**
+     * @brief 在block上变换，内部仍然经过split格式的缓冲
+     */
+    void FFTInplace(std::span<std::complex<T>> block) noexcept {
+        assert(block.size() == N);
+        Run<false>(reinterpret_cast<const T*>(block.data()), reinterpret_cast<T*>(block.data()));
+    }
+
+    /**
+     * @param normalize false: 不乘以1/N，输出为N倍
+     */
+    void IFFTInplace(std::span<std::complex<T>> block, bool normalize = true) noexcept {
+        assert(block.size() == N);
+        Run<true>(reinterpret_cast<const T*>(block.data()), reinterpret_cast<T*>(block.data()));
+        if (normalize) {
+            Normalize(block);
+        }
+    }
+
+    static constexpr size_t NumBins() noexcept {
+        return N;
+    }
+
+    static constexpr size_t FFTSize() noexcept {
+        return N;
+    }
+private:
+    static void Normalize(std::span<std::complex<T>> block) noexcept {
+        const T gain = T(1) / static_cast<T>(N);
+        for (auto& s : block) {
+            s *= gain;
+        }
+    }
+
+    template<bool kInverse>
+    void Run(const T* in, T* out) noexcept {
+        internal::Deinterleave(N, in, xr_.data(), xi_.data());
+        Finish<kInverse>(out);
+    }
+
+    template<bool kInverse>
+    void Finish(T* out) noexcept {
+        if (Kernel::template Transform<kInverse>(xr_.data(), xi_.data(), yr_.data(), yi_.data())) {
+            internal::Interleave(N, yr_.data(), yi_.data(), out);
+        }
+        else {
+            internal::Interleave(N, xr_.data(), xi_.data(), out);
+        }
+    }
+
+    std::array<T, N> xr_{};
+    std::array<T, N> xi_{};
+    std::array<T, N> yr_{};
+    std::array<T, N> yi_{};
+};
+
+/**
+ * @brief 编译期固定点数的实数FFT，N/2点复数FFT加一次后处理，全部工作区都在对象内部
+ * @note 和RealFFT的std::complex版本不同，这里X[N/2]没有取反，是标准DFT
+ * @tparam N 2的幂，>= 4
+ * @tparam T float或者double
+ */
+template<size_t N, class T = float>
+class RealFFTFixed {
+public:
+    static_assert(N >= 4, "N至少为4");
+    using Kernel = internal::FixedStockham<N / 2, T>;
+
+    void FFT(std::span<const T> time, std::span<std::complex<T>> spectral) noexcept {
+        assert(time.size() == N);
+        assert(spectral.size() == NumBins());
+        Forward(time.data(), internal::InterleavedBins<T>{reinterpret_cast<T*>(spectral.data())});
+    }
+
+    void FFT(std::span<const T> time, SplitSpectrum<T>& spectral) noexcept {
+        assert(time.size() == N);
+        assert(spectral.NumBins() == NumBins());
+        Forward(time.data(), internal::SplitBins<T>{spectral.real.data(), spectral.imag.data()});
+    }
+
+    /**
+     * @brief 乘以1/N，X[0]和X[N/2]的虚部被忽略
+     */
+    void IFFT(std::span<T> time, std::span<const std::complex<T>> spectral) noexcept {
+        assert(time.size() == N);
+        assert(spectral.size() == NumBins());
+        Backward(internal::ConstInterleavedBins<T>{reinterpret_cast<const T*>(spectral.data())}, time.data(), T(2) / static_cast<T>(N));
+    }
+
+    void IFFT(std::span<T> time, const SplitSpectrum<T>& spectral) noexcept {
+        assert(time.size() == N);
+        assert(spectral.NumBins() == NumBins());
+        Backward(internal::ConstSplitBins<T>{spectral.real.data(), spectral.imag.data()}, time.data(), T(2) / static_cast<T>(N));
+    }
+
+    /**
+     * @brief 输出为oouras的排列: [0] = X[0], [1] = X[N/2], [2k] = Re(X[k]), [2k+1] = -Im(X[k])
+     *        和RealFFT::FFTInplace一致，可以用RealFFT<T>::GetPackedBin访问
+     */
+    void FFTInplace(std::span<T> block) noexcept {
+        assert(block.size() == N);
+        Forward(block.data(), internal::PackedBins<T>{block.data()});
+    }
+
+    /**
+     * @param normalize false: 不乘以2/N，输出为N/2倍，和RealFFT::IFFTInplace一致
+     */
+    void IFFTInplace(std::span<T> block, bool normalize = true) noexcept {
+        assert(block.size() == N);
+        Backward(internal::PackedBins<T>{block.data()}, block.data(), normalize ? T(2) / static_cast<T>(N) : T(1));
+    }
+
+    static constexpr size_t NumBins() noexcept {
+        return N / 2 + 1;
+    }
+
+    static constexpr size_t FFTSize() noexcept {
+        return N;
+    }
+private:
+    static constexpr size_t kHalf = N / 2;
+
+    // 和SimdFFTTable::RealTwiddle一致: [0, h)为cos(2pi*k/N)，[h, 2h)为-sin(2pi*k/N)
+    static constexpr std::array<T, N> MakeRealTwiddle() noexcept {
+        std::array<T, N> table{};
+        for (size_t k = 0; k < kHalf; ++k) {
+            double c = 0;
+            double s = 0;
+            internal::FixedSinCos(k, N, c, s);
+            table[k] = static_cast<T>(c);
+            table[kHalf + k] = static_cast<T>(-s);
+        }
+        return table;
+    }
+
+    static constexpr std::array<T, N> kRealTwiddle = MakeRealTwiddle();
+
+    /**
+     * @brief 先把time全部读进内部缓冲，所以time可以和out是同一块内存
+     */
+    template<class Spectrum>
+    void Forward(const T* time, Spectrum out) noexcept {
+        internal::Deinterleave(kHalf, time, xr_.data(), xi_.data());
+        const T* wr = kRealTwiddle.data();
+        const T* wi = kRealTwiddle.data() + kHalf;
+        if (Kernel::template Transform<false>(xr_.data(), xi_.data(), yr_.data(), yi_.data())) {
+            internal::RealForward(kHalf, wr, wi, yr_.data(), yi_.data(), out);
+        }
+        else {
+            internal::RealForward(kHalf, wr, wi, xr_.data(), xi_.data(), out);
+        }
+    }
+
+    /**
+     * @param scale 1: 输出为N/2倍，和oouras的rdft(-1)一致
+     */
+    template<class Spectrum>
+    void Backward(Spectrum in, T* time, T scale) noexcept {
+        const T* wr = kRealTwiddle.data();
+        const T* wi = kRealTwiddle.data() + kHalf;
+        internal::RealBackward(kHalf, wr, wi, scale, in, xr_.data(), xi_.data());
+        if (Kernel::template Transform<true>(xr_.data(), xi_.data(), yr_.data(), yi_.data())) {
+            internal::Interleave(kHalf, yr_.data(), yi_.data(), time);
+        }
+        else {
+            internal::Interleave(kHalf, xr_.data(), xi_.data(), time);
+        }
+    }
+
+    std::array<T, N / 2> xr_{};
+    std::array<T, N / 2> xi_{};
+    std::array<T, N / 2> yr_{};
+    std::array<T, N / 2> yi_{};
+};
+}
\ No newline at end of file
@@ -0,0 +1,132 @@
+#pragma once
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <vector>
+#include "qwqdsp/spectral/simd_mac.hpp"
+#include "qwqdsp/spectral/split_spectrum.hpp"
+
+namespace qwqdsp::spectral {
+/**
+ * @brief 连续存放的一组split频谱，第i个频谱是[实部 | 虚部]，两部分都补齐到kAlign个float
+ *        分区卷积的IR用这个，复数乘加可以用固定的stride扫过所有分区
+ */
+class SpectrumArray {
+public:
+    static constexpr size_t kAlign = 16;
+
+    void Resize(size_t num_spectrums, size_t num_bins) {
+        size_ = num_spectrums;
+        num_bins_ = num_bins;
+        half_stride_ = (num_bins + kAlign - 1) / kAlign * kAlign;
+        data_.assign(num_spectrums * half_stride_ * 2, 0.0f);
+    }
+
+    void Clear() noexcept {
+        std::fill(data_.begin(), data_.end(), 0.0f);
+    }
+
+    void Set(size_t i, const SplitSpectrum<>& spectrum) noexcept {
+        assert(i < size_);
+        assert(spectrum.NumBins() == num_bins_);
+        std::copy_n(spectrum.real.begin(), num_bins_, Real(i));
+        std::copy_n(spectrum.imag.begin(), num_bins_, Imag(i));
+    }
+
+    float* Real(size_t i) noexcept {
+        return data_.data() + i * half_stride_ * 2;
+    }
+
+    float* Imag(size_t i) noexcept {
+        return Real(i) + half_stride_;
+    }
+
+    const float* Data(size_t i) const noexcept {
+        return data_.data() + i * half_stride_ * 2;
+    }
+
+    /**
+     * @brief 相邻两个频谱的距离，虚部在Stride() / 2
+     */
+    size_t Stride() const noexcept {
+        return half_stride_ * 2;
+    }
+
+    size_t NumBins() const noexcept {
+        return num_bins_;
+    }
+
+    size_t Size() const noexcept {
+        return size_;
+    }
+private:
+    size_t size_{};
+    size_t num_bins_{};
+    size_t half_stride_{};
+    std::vector<float> data_;
+};
+
+/**
+ * @brief 频谱延迟线，最新的depth个输入频谱
+ *        存了两份，最新的在前，任何时候最近的depth个频谱在内存里都是连续的，
+ *        乘加时不需要对每个分区取模，可以直接和SpectrumArray一起流式访问
+ */
+class FrequencyDelayLine {
+public:
+    void Resize(size_t depth, size_t num_bins) {
+        assert(depth > 0);
+        depth_ = depth;
+        spectrums_.Resize(depth * 2, num_bins);
+        wpos_ = 0;
+    }
+
+    void Reset() noexcept {
+        spectrums_.Clear();
+        wpos_ = 0;
+    }
+
+    void Push(const SplitSpectrum<>& spectrum) noexcept {
+        wpos_ = wpos_ == 0 ? depth_ - 1 : wpos_ - 1;
+        spectrums_.Set(wpos_, spectrum);
+        spectrums_.Set(wpos_ + depth_, spectrum);
+    }
+
+    /**
+     * @brief out = sum_p Get(p) * ir[p]，accumulate为true时累加到out上
+     * @param ir 分区数 <= Depth()
+     */
+    void MultiplyAccumulate(const SpectrumArray& ir, SplitSpectrum<>& out, bool accumulate) const noexcept {
+        assert(ir.Size() <= depth_);
+        assert(ir.Size() == 0 || ir.NumBins() == NumBins());
+        assert(out.NumBins() == NumBins());
+        internal::simd_complex_mac(
+            NumBins(), ir.Size(), spectrums_.Stride(),
+            spectrums_.Data(wpos_), ir.Data(0), out.real.data(), out.imag.data(), accumulate
+        );
+    }
+
+    /**
+     * @brief 第i新的频谱，0是最近一次Push的
+     */
+    const float* Get(size_t i) const noexcept {
+        assert(i < depth_);
+        return spectrums_.Data(wpos_ + i);
+    }
+
+    size_t Depth() const noexcept {
+        return depth_;
+    }
+
+    size_t NumBins() const noexcept {
+        return spectrums_.NumBins();
+    }
+
+    size_t Stride() const noexcept {
+        return spectrums_.Stride();
+    }
+private:
+    SpectrumArray spectrums_;
+    size_t depth_{};
+    size_t wpos_{};
+};
+}
\ No newline at end of file
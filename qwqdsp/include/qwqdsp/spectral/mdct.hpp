@@ -0,0 +1,229 @@
+#pragma once
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <complex>
+#include <cstddef>
+#include <numbers>
+#include <span>
+#include <vector>
+#include "qwqdsp/spectral/complex_fft.hpp"
+#include "qwqdsp/segement/slice.hpp"
+#include "qwqdsp/window/kaiser.hpp"
+
+namespace qwqdsp::spectral {
+/**
+ * @brief 加窗的MDCT/IMDCT，帧长2M，跳步M，每帧M个系数，是临界采样的
+ *        X[k] = sum_{n=0}^{2M-1} w[n] * x[n] * cos(pi/M * (n + 0.5 + M/2) * (k + 0.5))
+ *        Inverse已经乘过窗和2/M，相邻帧直接重叠相加就能消掉时域混叠(TDAC)
+ *        内部折叠成M点DCT-IV，再用M/2点复数FFT计算
+ * @tparam T float或者double
+ */
+template<class T = float>
+class MDCT {
+public:
+    /**
+     * @param num_bins M，跳步也是M，必须是偶数
+     */
+    void Init(size_t num_bins) {
+        assert(num_bins >= 2 && num_bins % 2 == 0);
+        num_bins_ = num_bins;
+        const size_t half = num_bins / 2;
+        fft_.Init(half);
+        fft_buffer_.resize(half);
+        pre_twiddle_.resize(half);
+        post_twiddle_.resize(half);
+        const double m = static_cast<double>(num_bins);
+        for (size_t i = 0; i < half; ++i) {
+            const double pre = -std::numbers::pi * (4.0 * static_cast<double>(i) + 1.0) / (4.0 * m);
+            const double post = -std::numbers::pi * static_cast<double>(i) / m;
+            pre_twiddle_[i] = {static_cast<T>(std::cos(pre)), static_cast<T>(std::sin(pre))};
+            post_twiddle_[i] = {static_cast<T>(std::cos(post)), static_cast<T>(std::sin(post))};
+        }
+        fold_.resize(num_bins);
+        window_.resize(num_bins * 2);
+        input_buffer_.resize(num_bins * 2);
+        output_buffer_.resize(num_bins);
+        overlap_.resize(num_bins);
+        frame_.resize(num_bins * 2);
+        coeffs_.resize(num_bins);
+        SetSineWindow();
+        Reset();
+    }
+
+    /**
+     * @brief w[n] = sin(pi/2M * (n + 0.5))
+     */
+    void SetSineWindow() noexcept {
+        const size_t n = window_.size();
+        for (size_t i = 0; i < n; ++i) {
+            window_[i] = static_cast<T>(std::sin(std::numbers::pi * (static_cast<double>(i) + 0.5) / static_cast<double>(n)));
+        }
+    }
+
+    /**
+     * @brief Kaiser-Bessel derived窗，AAC用的那种
+     * @param alpha 越大阻带越低，主瓣越宽，AAC长窗为4，短窗为6
+     */
+    void SetKBDWindow(float alpha = 4.0f) {
+        const size_t m = num_bins_;
+        std::vector<float> kaiser(m + 1);
+        window::Kaiser::Window(kaiser, std::numbers::pi_v<float> * alpha, false);
+        // float算出来的Kaiser窗不是严格对称的，对称之后才能严格满足w[n]^2 + w[n+M]^2 = 1
+        std::vector<T> cumsum(m + 1);
+        T sum = 0;
+        for (size_t i = 0; i <= m; ++i) {
+            sum += (static_cast<T>(kaiser[i]) + static_cast<T>(kaiser[m - i])) * T(0.5);
+            cumsum[i] = sum;
+        }
+        for (size_t i = 0; i < m; ++i) {
+            window_[i] = std::sqrt(cumsum[i] / sum);
+            window_[m * 2 - 1 - i] = window_[i];
+        }
+    }
+
+    /**
+     * @tparam Func void(std::span<T> window)，长度为2M
+     * @note 需要满足Princen-Bradley条件 w[n] = w[2M-1-n], w[n]^2 + w[n+M]^2 = 1，否则不能完美重建
+     */
+    template<class Func>
+    void ChangeWindow(Func&& func) noexcept(noexcept(func(std::declval<std::span<T>>()))) {
+        func(std::span<T>{window_});
+    }
+
+    /**
+     * @param input 2M个采样，内部会加窗
+     * @param output M个系数
+     */
+    void Forward(std::span<const T> input, std::span<T> output) noexcept {
+        assert(input.size() == num_bins_ * 2);
+        assert(output.size() == num_bins_);
+        const size_t m = num_bins_;
+        const size_t half = m / 2;
+        // 分成a b c d四段，折叠成(-c_r - d, a - b_r)
+        for (size_t i = 0; i < half; ++i) {
+            const size_t r = m + half - 1 - i;
+            const size_t d = m + half + i;
+            fold_[i] = -input[r] * window_[r] - input[d] * window_[d];
+        }
+        for (size_t i = half; i < m; ++i) {
+            const size_t a = i - half;
+            const size_t r = m + half - 1 - i;
+            fold_[i] = input[a] * window_[a] - input[r] * window_[r];
+        }
+        DCT4(fold_, output);
+    }
+
+    /**
+     * @param input M个系数
+     * @param output 2M个采样，已经加窗，和上一帧的后半段相加就是重建的M个采样
+     */
+    void Inverse(std::span<const T> input, std::span<T> output) noexcept {
+        assert(input.size() == num_bins_);
+        assert(output.size() == num_bins_ * 2);
+        const size_t m = num_bins_;
+        const size_t half = m / 2;
+        DCT4(input, fold_);
+        // DCT-IV的逆是自身乘以2/M
+        const T gain = T(2) / static_cast<T>(m);
+        for (size_t i = 0; i < half; ++i) {
+            output[i] = fold_[i + half] * gain * window_[i];
+        }
+        for (size_t i = half; i < m + half; ++i) {
+            output[i] = -fold_[m + half - 1 - i] * gain * window_[i];
+        }
+        for (size_t i = m + half; i < m * 2; ++i) {
+            output[i] = -fold_[i - m - half] * gain * window_[i];
+        }
+    }
+
+    /**
+     * @brief 流式处理，任意长度的block，延迟为GetLatency()
+     * @tparam Func void(std::span<T> coeffs)，可以直接修改M个系数
+     */
+    template<class Func>
+    void Process(std::span<T> block, Func&& func) noexcept(noexcept(func(std::declval<std::span<T>>()))) {
+        const size_t m = num_bins_;
+        segement::Slice1D input{block};
+        while (!input.IsEnd()) {
+            size_t need = m - input_wpos_;
+            auto in = input.GetSome(need);
+            for (size_t i = 0; i < in.size(); ++i) {
+                input_buffer_[m + input_wpos_ + i] = in[i];
+                in[i] = output_buffer_[input_wpos_ + i];
+            }
+            input_wpos_ += in.size();
+            if (input_wpos_ >= m) {
+                Forward(input_buffer_, coeffs_);
+                func(std::span<T>{coeffs_});
+                Inverse(coeffs_, frame_);
+                for (size_t i = 0; i < m; ++i) {
+                    output_buffer_[i] = overlap_[i] + frame_[i];
+                    overlap_[i] = frame_[i + m];
+                }
+                std::copy_n(input_buffer_.begin() + m, m, input_buffer_.begin());
+                input_wpos_ = 0;
+            }
+        }
+    }
+
+    void Reset() noexcept {
+        std::fill(input_buffer_.begin(), input_buffer_.end(), T{});
+        std::fill(output_buffer_.begin(), output_buffer_.end(), T{});
+        std::fill(overlap_.begin(), overlap_.end(), T{});
+        input_wpos_ = 0;
+    }
+
+    /**
+     * @brief Process的延迟，2M个采样
+     */
+    size_t GetLatency() const noexcept {
+        return num_bins_ * 2;
+    }
+
+    size_t NumBins() const noexcept {
+        return num_bins_;
+    }
+
+    size_t FrameSize() const noexcept {
+        return num_bins_ * 2;
+    }
+
+    std::span<const T> GetWindow() const noexcept {
+        return window_;
+    }
+private:
+    /**
+     * @brief X[k] = sum_{n=0}^{M-1} x[n] * cos(pi/M * (n + 0.5) * (k + 0.5))
+     */
+    void DCT4(std::span<const T> input, std::span<T> output) noexcept {
+        const size_t m = num_bins_;
+        const size_t half = m / 2;
+        for (size_t i = 0; i < half; ++i) {
+            fft_buffer_[i] = std::complex<T>{input[i * 2], input[m - 1 - i * 2]} * pre_twiddle_[i];
+        }
+        fft_.FFTInplace(fft_buffer_);
+        for (size_t i = 0; i < half; ++i) {
+            const auto z = fft_buffer_[i] * post_twiddle_[i];
+            output[i * 2] = z.real();
+            output[m - 1 - i * 2] = -z.imag();
+        }
+    }
+
+    size_t num_bins_{};
+    ComplexFFT<false, T> fft_;
+    std::vector<std::complex<T>> fft_buffer_;
+    std::vector<std::complex<T>> pre_twiddle_;
+    std::vector<std::complex<T>> post_twiddle_;
+    std::vector<T> fold_;
+    std::vector<T> window_;
+
+    // 流式处理
+    std::vector<T> input_buffer_;
+    std::vector<T> output_buffer_;
+    std::vector<T> overlap_;
+    std::vector<T> frame_;
+    std::vector<T> coeffs_;
+    size_t input_wpos_{};
+};
+}
\ No newline at end of file
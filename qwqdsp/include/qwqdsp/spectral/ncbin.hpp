@@ -44,10 +44,10 @@ public:
     }
 
     static constexpr size_t NumData(size_t size) noexcept {
-        return RealFFT::NumBins(size) - 1;
+        return RealFFT<>::NumBins(size) - 1;
     }
 private:
-    RealFFT fft_;
+    RealFFT<> fft_;
     std::vector<std::complex<float>> spectral_;
 };
 }
\ No newline at end of file
@@ -1,34 +1,63 @@
 #pragma once
+#include <algorithm>
+#include <array>
+#include <cmath>
 #include <cstddef>
+#include <memory>
 #include <span>
+#include <type_traits>
 #include <vector>
 #include <complex>
 #include <cassert>
+#include "qwqdsp/spectral/fft_plan.hpp"
+#include "qwqdsp/spectral/split_spectrum.hpp"
 
 namespace qwqdsp::spectral {
 namespace internal {
-void rdft(int, int, float *, int *, float *) noexcept;
-void makewt(int nw, int *ip, float *w) noexcept;
-void makect(int nc, int *ip, float *c) noexcept;
+template<class T>
+void rdft(int, int, T *, int *, T *) noexcept;
 }
+
+/**
+ * @tparam T float或者double，double版本没有批处理，FFTBatch逐个处理
+ */
+template<class T = float>
 class RealFFT {
 public:
-    void Init(size_t fft_size) {
+    /**
+     * @param fft_size 偶数，不是2的幂时使用kMixedRadix后端
+     * @param backend 计算后端，输出完全一致
+     */
+    void Init(size_t fft_size, FFTBackend backend = kDefaultFFTBackend) {
+        assert(fft_size % 2 == 0);
+        if (!internal::IsPowerOfTwo(fft_size)) {
+            backend = FFTBackend::kMixedRadix;
+        }
         fft_size_ = fft_size;
-        ip_.resize(2 + std::ceil(std::sqrt(fft_size / 2.0f)));
-        w_.resize(fft_size / 2);
+        backend_ = backend;
         buffer_.resize(fft_size);
-        const size_t size4 = fft_size / 4;
-        internal::makewt(size4, ip_.data(), w_.data());
-        internal::makect(size4, ip_.data(), w_.data() + size4);
+        plan_ = FFTPlan<T>::Get(fft_size, FFTPlan<T>::Type::kReal, backend);
+        simd_batch_work_.clear();
+        if (backend == FFTBackend::kMixedRadix) {
+            work_.resize(plan_->mixed.WorkSize());
+        }
+        else if (backend == FFTBackend::kSimd) {
+            work_.resize(fft_size * 2);
+            if (std::is_same_v<T, float> && fft_size / 2 <= internal::kSimdBatchMaxComplexSize) {
+                simd_batch_work_.resize(fft_size * 2 * internal::kSimdBatchLanes);
+            }
+        }
+        else {
+            ip_ = plan_->MakeOouraIp();
+        }
     }
 
-    void FFT(std::span<const float> time, std::span<std::complex<float>> spectral) noexcept {
+    void FFT(std::span<const T> time, std::span<std::complex<T>> spectral) noexcept {
         assert(time.size() == fft_size_);
         assert(spectral.size() == NumBins());
 
         std::copy(time.begin(), time.end(), buffer_.begin());
-        internal::rdft(fft_size_, 1, buffer_.data(), ip_.data(), w_.data());
+        Rdft(1);
         spectral.front().real(buffer_[0]);
         spectral.front().imag(0.0f);
         spectral[fft_size_ / 2].real(-buffer_[1]);
@@ -40,13 +69,13 @@ public:
         }
     }
 
-    void FFT(std::span<const float> time, std::span<float> real, std::span<float> imag) noexcept {
+    void FFT(std::span<const T> time, std::span<T> real, std::span<T> imag) noexcept {
         assert(time.size() == fft_size_);
         assert(real.size() == NumBins());
         assert(imag.size() == NumBins());
 
         std::copy(time.begin(), time.end(), buffer_.begin());
-        internal::rdft(fft_size_, 1, buffer_.data(), ip_.data(), w_.data());
+        Rdft(1);
         real.front() = buffer_[0];
         imag.front() = 0.0f;
         real[fft_size_ / 2] = -buffer_[1];
@@ -58,7 +87,7 @@ public:
         }
     }
 
-    void IFFT(std::span<float> time, std::span<const std::complex<float>> spectral) noexcept {
+    void IFFT(std::span<T> time, std::span<const std::complex<T>> spectral) noexcept {
         assert(time.size() == fft_size_);
         assert(spectral.size() == NumBins());
 
@@ -69,14 +98,14 @@ public:
             buffer_[2 * i] = spectral[i].real();
             buffer_[2 * i + 1] = -spectral[i].imag();
         }
-        internal::rdft(fft_size_, -1, buffer_.data(), ip_.data(), w_.data());
-        float gain = 2.0f / fft_size_;
+        Rdft(-1);
+        T gain = T(2) / static_cast<T>(fft_size_);
         for (size_t i = 0; i < fft_size_; ++i) {
             time[i] = buffer_[i] * gain;
         }
     }
 
-    void IFFT(std::span<float> time, std::span<const float> real, std::span<const float> imag) noexcept {
+    void IFFT(std::span<T> time, std::span<const T> real, std::span<const T> imag) noexcept {
         assert(time.size() == fft_size_);
         assert(real.size() == NumBins());
         assert(imag.size() == NumBins());
@@ -88,17 +117,132 @@ public:
             buffer_[2 * i] = real[i];
             buffer_[2 * i + 1] = -imag[i];
         }
-        internal::rdft(fft_size_, -1, buffer_.data(), ip_.data(), w_.data());
-        float gain = 2.0f / fft_size_;
+        Rdft(-1);
+        T gain = T(2) / static_cast<T>(fft_size_);
         for (size_t i = 0; i < fft_size_; ++i) {
             time[i] = buffer_[i] * gain;
         }
     }
 
+    /**
+     * @brief 输出split格式的标准DFT，simd后端不经过中间缓冲直接写入
+     * @note 和std::span<T> real/imag的版本不同，这里X[N/2]没有取反
+     */
+    void FFT(std::span<const T> time, SplitSpectrum<T>& spectral) noexcept {
+        assert(time.size() == fft_size_);
+        assert(spectral.NumBins() == NumBins());
+
+        if (backend_ == FFTBackend::kSimd) {
+            internal::simd_rdft_split(fft_size_, time.data(), spectral.real.data(), spectral.imag.data(), plan_->simd, work_.data());
+            return;
+        }
+
+        std::copy(time.begin(), time.end(), buffer_.begin());
+        Rdft(1);
+        spectral.real.front() = buffer_[0];
+        spectral.imag.front() = 0.0f;
+        spectral.real[fft_size_ / 2] = buffer_[1];
+        spectral.imag[fft_size_ / 2] = 0.0f;
+        const size_t n = fft_size_ / 2;
+        for (size_t i = 1; i < n; ++i) {
+            spectral.real[i] = buffer_[i * 2];
+            spectral.imag[i] = -buffer_[i * 2 + 1];
+        }
+    }
+
+    void IFFT(std::span<T> time, const SplitSpectrum<T>& spectral) noexcept {
+        assert(time.size() == fft_size_);
+        assert(spectral.NumBins() == NumBins());
+
+        if (backend_ == FFTBackend::kSimd) {
+            internal::simd_irdft_split(fft_size_, spectral.real.data(), spectral.imag.data(), time.data(), plan_->simd, work_.data());
+            return;
+        }
+
+        buffer_[0] = spectral.real.front();
+        buffer_[1] = spectral.real[fft_size_ / 2];
+        const size_t n = fft_size_ / 2;
+        for (size_t i = 1; i < n; ++i) {
+            buffer_[2 * i] = spectral.real[i];
+            buffer_[2 * i + 1] = -spectral.imag[i];
+        }
+        Rdft(-1);
+        T gain = T(2) / static_cast<T>(fft_size_);
+        for (size_t i = 0; i < fft_size_; ++i) {
+            time[i] = buffer_[i] * gain;
+        }
+    }
+
+    /**
+     * @brief 一次对多个通道做FFT，第c个通道的时域从time[c * stride]开始，频谱写入spectral[c]
+     *        simd后端把kSimdBatchLanes个通道交错在一起计算，每一级蝴蝶都在通道方向向量化
+     * @param stride 相邻通道在time中的距离，>= FFTSize()
+     */
+    void FFTBatch(std::span<const T> time, size_t stride, std::span<SplitSpectrum<T>> spectral) noexcept {
+        const size_t count = spectral.size();
+        assert(stride >= fft_size_);
+        assert(count == 0 || time.size() >= (count - 1) * stride + fft_size_);
+
+        if (simd_batch_work_.empty()) {
+            for (size_t c = 0; c < count; ++c) {
+                FFT(time.subspan(c * stride, fft_size_), spectral[c]);
+            }
+            return;
+        }
+
+        if constexpr (std::is_same_v<T, float>) {
+            std::array<const float*, internal::kSimdBatchLanes> in;
+            std::array<float*, internal::kSimdBatchLanes> re;
+            std::array<float*, internal::kSimdBatchLanes> im;
+            for (size_t begin = 0; begin < count; begin += internal::kSimdBatchLanes) {
+                const size_t num = std::min(internal::kSimdBatchLanes, count - begin);
+                for (size_t c = 0; c < num; ++c) {
+                    assert(spectral[begin + c].NumBins() == NumBins());
+                    in[c] = time.data() + (begin + c) * stride;
+                    re[c] = spectral[begin + c].real.data();
+                    im[c] = spectral[begin + c].imag.data();
+                }
+                internal::simd_rdft_batch(fft_size_, num, in.data(), re.data(), im.data(), plan_->simd, simd_batch_work_.data());
+            }
+        }
+    }
+
+    /**
+     * @brief FFTBatch的逆变换，第c个通道写入time[c * stride]开始的FFTSize()个点
+     */
+    void IFFTBatch(std::span<T> time, size_t stride, std::span<const SplitSpectrum<T>> spectral) noexcept {
+        const size_t count = spectral.size();
+        assert(stride >= fft_size_);
+        assert(count == 0 || time.size() >= (count - 1) * stride + fft_size_);
+
+        if (simd_batch_work_.empty()) {
+            for (size_t c = 0; c < count; ++c) {
+                IFFT(time.subspan(c * stride, fft_size_), spectral[c]);
+            }
+            return;
+        }
+
+        if constexpr (std::is_same_v<T, float>) {
+            std::array<const float*, internal::kSimdBatchLanes> re;
+            std::array<const float*, internal::kSimdBatchLanes> im;
+            std::array<float*, internal::kSimdBatchLanes> out;
+            for (size_t begin = 0; begin < count; begin += internal::kSimdBatchLanes) {
+                const size_t num = std::min(internal::kSimdBatchLanes, count - begin);
+                for (size_t c = 0; c < num; ++c) {
+                    assert(spectral[begin + c].NumBins() == NumBins());
+                    re[c] = spectral[begin + c].real.data();
+                    im[c] = spectral[begin + c].imag.data();
+                    out[c] = time.data() + (begin + c) * stride;
+                }
+                internal::simd_irdft_batch(fft_size_, num, re.data(), im.data(), out.data(), plan_->simd, simd_batch_work_.data());
+            }
+        }
+    }
+
     /**
      * @param phase 可选的，不需要请传入{}
      */
-    void FFTGainPhase(std::span<const float> time, std::span<float> gain, std::span<float> phase = {}) noexcept {
+    void FFTGainPhase(std::span<const T> time, std::span<T> gain, std::span<T> phase = {}) noexcept {
         assert(time.size() == fft_size_);
         assert(gain.size() == NumBins());
         if (!phase.empty()) {
@@ -106,14 +250,14 @@ public:
         }
 
         std::copy(time.begin(), time.end(), buffer_.begin());
-        internal::rdft(fft_size_, 1, buffer_.data(), ip_.data(), w_.data());
+        Rdft(1);
         if (phase.empty()) {
             gain.front() = std::abs(buffer_[0]);
             gain[fft_size_ / 2] = std::abs(buffer_[1]);
             const size_t n = fft_size_ / 2;
             for (size_t i = 1; i < n; ++i) {
-                float real = buffer_[i * 2];
-                float imag = -buffer_[i * 2 + 1];
+                T real = buffer_[i * 2];
+                T imag = -buffer_[i * 2 + 1];
                 gain[i] = std::sqrt(real * real + imag * imag);
             }
         }
@@ -124,15 +268,15 @@ public:
             phase[fft_size_ / 2] = 0.0f;
             const size_t n = fft_size_ / 2;
             for (size_t i = 1; i < n; ++i) {
-                float real = buffer_[i * 2];
-                float imag = -buffer_[i * 2 + 1];
+                T real = buffer_[i * 2];
+                T imag = -buffer_[i * 2 + 1];
                 gain[i] = std::sqrt(real * real + imag + imag);
                 phase[i] = std::atan2(imag, real);
             }
         }
     }
 
-    void IFFTGainPhase(std::span<float> time, std::span<const float> gain, std::span<const float> phase) noexcept {
+    void IFFTGainPhase(std::span<T> time, std::span<const T> gain, std::span<const T> phase) noexcept {
         assert(time.size() == fft_size_);
         assert(gain.size() == NumBins());
         assert(phase.size() == NumBins());
@@ -144,24 +288,80 @@ public:
             buffer_[2 * i] = gain[i] * std::cos(phase[i]);
             buffer_[2 * i + 1] = -gain[i] * std::sin(phase[i]);
         }
-        internal::rdft(fft_size_, -1, buffer_.data(), ip_.data(), w_.data());
-        float g = 2.0f / fft_size_;
+        Rdft(-1);
+        T g = T(2) / static_cast<T>(fft_size_);
         for (size_t i = 0; i < fft_size_; ++i) {
             time[i] = buffer_[i] * g;
         }
     }
 
-    void Hilbert(std::span<const float> input, std::span<float> shift90, bool clear_dc) noexcept {
+    /**
+     * @brief 直接在block上变换，不经过内部缓冲也不重排
+     *        输出为oouras的排列: [0] = X[0], [1] = X[N/2], [2k] = Re(X[k]), [2k+1] = -Im(X[k])
+     *        用GetPackedBin/SetPackedBin访问
+     */
+    void FFTInplace(std::span<T> block) noexcept {
+        assert(block.size() == fft_size_);
+        Rdft(1, block.data());
+    }
+
+    /**
+     * @brief FFTInplace的逆变换
+     * @param normalize false: 不乘以2/N，输出为N/2倍，增益可以提前合并进频谱里省去一次遍历
+     */
+    void IFFTInplace(std::span<T> block, bool normalize = true) noexcept {
+        assert(block.size() == fft_size_);
+        Rdft(-1, block.data());
+        if (normalize) {
+            const T gain = T(2) / static_cast<T>(fft_size_);
+            for (T& s : block) {
+                s *= gain;
+            }
+        }
+    }
+
+    /**
+     * @brief 读取FFTInplace输出的第k个bin，k = 0 ~ N/2
+     */
+    static std::complex<T> GetPackedBin(std::span<const T> packed, size_t k) noexcept {
+        assert(k <= packed.size() / 2);
+        if (k == 0) {
+            return {packed[0], 0.0f};
+        }
+        if (k == packed.size() / 2) {
+            return {packed[1], 0.0f};
+        }
+        return {packed[2 * k], -packed[2 * k + 1]};
+    }
+
+    /**
+     * @brief 写入第k个bin，k = 0和N/2时虚部被忽略
+     */
+    static void SetPackedBin(std::span<T> packed, size_t k, std::complex<T> bin) noexcept {
+        assert(k <= packed.size() / 2);
+        if (k == 0) {
+            packed[0] = bin.real();
+        }
+        else if (k == packed.size() / 2) {
+            packed[1] = bin.real();
+        }
+        else {
+            packed[2 * k] = bin.real();
+            packed[2 * k + 1] = -bin.imag();
+        }
+    }
+
+    void Hilbert(std::span<const T> input, std::span<T> shift90, bool clear_dc) noexcept {
         assert(input.size() == fft_size_);
         assert(shift90.size() == fft_size_);
         std::copy(input.begin(), input.end(), buffer_.begin());
-        internal::rdft(fft_size_, 1, buffer_.data(), ip_.data(), w_.data());
+        Rdft(1);
         const size_t n = fft_size_ / 2;
         for (size_t i = 1; i < n; ++i) {
-            float real = buffer_[i * 2];
-            float imag = -buffer_[i * 2 + 1];
-            float re = imag;
-            float im = -real;
+            T real = buffer_[i * 2];
+            T imag = -buffer_[i * 2 + 1];
+            T re = imag;
+            T im = -real;
             buffer_[i * 2] = re;
             buffer_[i * 2 + 1] = -im;
         }
@@ -169,8 +369,8 @@ public:
             buffer_[0] = 0;
             buffer_[1] = 0;
         }
-        internal::rdft(fft_size_, -1, buffer_.data(), ip_.data(), w_.data());
-        float gain = 2.0f / fft_size_;
+        Rdft(-1);
+        T gain = T(2) / static_cast<T>(fft_size_);
         for (size_t i = 0; i < fft_size_; ++i) {
             shift90[i] = buffer_[i] * gain;
         }
@@ -179,7 +379,7 @@ public:
     /**
      * @brief 0 ~ N ---> -N/2 ~ N/2
      */
-    void TimeDomainShift(std::span<float> block) noexcept {
+    void TimeDomainShift(std::span<T> block) noexcept {
         assert(block.size() == fft_size_);
         std::copy_n(block.begin(), fft_size_ / 2, buffer_.begin());
         for (size_t i = 0; i < fft_size_ / 2; ++i) {
@@ -203,10 +403,37 @@ public:
     float FFTSizeFloat() const {
         return static_cast<float>(fft_size_);
     }
+
+    FFTBackend Backend() const noexcept {
+        return backend_;
+    }
 private:
+    void Rdft(int isgn) noexcept {
+        Rdft(isgn, buffer_.data());
+    }
+
+    void Rdft(int isgn, T* a) noexcept {
+        if (backend_ == FFTBackend::kSimd) {
+            internal::simd_rdft(fft_size_, isgn, a, plan_->simd, work_.data());
+        }
+        else if (backend_ == FFTBackend::kMixedRadix) {
+            internal::mixed_rdft(fft_size_, isgn, a, plan_->mixed, work_.data());
+        }
+        else {
+            // ip[0]和ip[1]已经填好，rdft只读w
+            internal::rdft(fft_size_, isgn, a, ip_.data(), const_cast<T*>(plan_->ooura_w.data()));
+        }
+    }
+
     size_t fft_size_{};
+    FFTBackend backend_{};
+    // 旋转因子表是共享的，其余都是实例自己的工作区
+    std::shared_ptr<const FFTPlan<T>> plan_;
     std::vector<int> ip_;
-    std::vector<float> w_;
-    std::vector<float> buffer_;
+    std::vector<T> buffer_;
+    // 计算后端的工作区
+    std::vector<T> work_;
+    // 只有simd后端并且点数不超过kSimdBatchMaxComplexSize时才分配，否则Batch逐个处理
+    std::vector<T> simd_batch_work_;
 };
 }
\ No newline at end of file
@@ -113,7 +113,7 @@ private:
     }
 
     float gain_scaleback_{};
-    RealFFT fft_;
+    RealFFT<> fft_;
     std::vector<float> buffer_;
     std::vector<float> window_;
     std::vector<std::complex<float>> common_;
@@ -215,7 +215,7 @@ public:
         return fft_.NumBins();
     }
 private:
-    RealFFT fft_;
+    RealFFT<> fft_;
     std::vector<float> buffer_;
     std::vector<float> window_;
     std::vector<float> dwindow_;
@@ -0,0 +1,204 @@
+#pragma once
+#include <cstddef>
+#include <vector>
+
+namespace qwqdsp::spectral {
+/**
+ * @brief FFT的计算后端，输出的排列和缩放完全一致
+ *   kOoura:      原本的Ooura标量实现
+ *   kSimd:       split格式的radix-4 Stockham实现，有SSE/AVX时向量化，否则退化为标量
+ *   kMixedRadix: 任意点数，2 3 5 7的mixed radix，其他因子用Bluestein，点数不是2的幂时Init自动切换到这里
+ */
+enum class FFTBackend {
+    kOoura,
+    kSimd,
+    kMixedRadix
+};
+
+/**
+ * @brief 定义QWQDSP_FFT_DEFAULT_SIMD可以在编译期把默认后端切换为kSimd
+ */
+#ifdef QWQDSP_FFT_DEFAULT_SIMD
+inline constexpr FFTBackend kDefaultFFTBackend = FFTBackend::kSimd;
+#else
+inline constexpr FFTBackend kDefaultFFTBackend = FFTBackend::kOoura;
+#endif
+
+namespace internal {
+
+// --------------------------------------------------------------------------------
+// simd fft
+//
+// 接口和oouras一致，a的排列、符号、缩放都和cdft/rdft相同，可以直接替换
+// T为float或者double，work至少需要2n个T
+// --------------------------------------------------------------------------------
+
+template<class T>
+class SimdFFTTable {
+public:
+    /**
+     * @param n 复数FFT的点数，2的幂
+     * @param real true: 表给实数FFT使用，n为实数点数，内部做n/2点复数FFT
+     */
+    void Init(size_t n, bool real);
+
+    /**
+     * @return 内部复数FFT的点数
+     */
+    size_t ComplexSize() const noexcept {
+        return complex_size_;
+    }
+
+    const T* Twiddle() const noexcept {
+        return twiddle_.data();
+    }
+
+    const T* RealTwiddle() const noexcept {
+        return real_twiddle_.data();
+    }
+private:
+    size_t complex_size_{};
+    // 每一级radix-4: w1 w2 w3的实部和虚部，各m = L/4个
+    std::vector<T> twiddle_;
+    // 实数FFT后处理: exp(-2pi*i*k/n)的实部和虚部，各n/2个
+    std::vector<T> real_twiddle_;
+};
+
+template<class T>
+void simd_cdft(int n, int isgn, T* a, const SimdFFTTable<T>& table, T* work) noexcept;
+template<class T>
+void simd_rdft(int n, int isgn, T* a, const SimdFFTTable<T>& table, T* work) noexcept;
+// 不经过oouras排列，直接输出split格式的标准DFT，re和im各n/2+1个
+template<class T>
+void simd_rdft_split(int n, const T* time, T* re, T* im, const SimdFFTTable<T>& table, T* work) noexcept;
+// simd_rdft_split的逆变换，输出已经乘以了1/n
+template<class T>
+void simd_irdft_split(int n, const T* re, const T* im, T* time, const SimdFFTTable<T>& table, T* work) noexcept;
+
+// --------------------------------------------------------------------------------
+// 批处理
+//
+// 最多kSimdBatchLanes个通道交错存放(第k个点的第c个通道在k * kSimdBatchLanes + c)
+// 相当于Stockham从stride = kSimdBatchLanes开始，每一级都能在通道方向向量化
+// count <= kSimdBatchLanes，work至少需要4 * 复数点数 * kSimdBatchLanes个float，只有float版本
+// --------------------------------------------------------------------------------
+
+inline constexpr size_t kSimdBatchLanes = 8;
+// 交错之后的工作区是单个FFT的kSimdBatchLanes倍，点数再大就超出L1，逐个处理反而更快
+inline constexpr size_t kSimdBatchMaxComplexSize = 128;
+
+// 等价于对每个通道调用simd_rdft_split
+void simd_rdft_batch(
+    int n, size_t count, const float* const* time, float* const* re, float* const* im,
+    const SimdFFTTable<float>& table, float* work
+) noexcept;
+// 等价于对每个通道调用simd_irdft_split
+void simd_irdft_batch(
+    int n, size_t count, const float* const* re, const float* const* im, float* const* time,
+    const SimdFFTTable<float>& table, float* work
+) noexcept;
+/**
+ * @brief n点复数的标准DFT，数据为交错的复数
+ *        输入的第k个点从in[(k + in_rotate) % n]读取，输出的第k个点写入out[(k + out_rotate) % n]
+ * @param inverse false: exp(-i)，true: exp(+i)
+ * @param scale 输出的增益
+ */
+void simd_cdft_batch(
+    int n, bool inverse, size_t count, const float* const* in, float* const* out,
+    size_t in_rotate, size_t out_rotate, float scale,
+    const SimdFFTTable<float>& table, float* work
+) noexcept;
+
+// --------------------------------------------------------------------------------
+// mixed radix
+//
+// 任意点数，分解为4 2 3 5 7的Stockham，有其他质因子时整个变换走Bluestein
+// 接口和oouras一致，work至少需要MixedFFTTable::WorkSize()个T
+// --------------------------------------------------------------------------------
+
+constexpr bool IsPowerOfTwo(size_t n) noexcept {
+    return n != 0 && (n & (n - 1)) == 0;
+}
+
+template<class T>
+class MixedFFTTable {
+public:
+    struct Stage {
+        size_t radix;
+        size_t len;
+    };
+
+    /**
+     * @param n 复数FFT的点数
+     * @param real true: 表给实数FFT使用，n为实数点数(偶数)，内部做n/2点复数FFT
+     */
+    void Init(size_t n, bool real);
+
+    size_t ComplexSize() const noexcept {
+        return complex_size_;
+    }
+
+    bool UseBluestein() const noexcept {
+        return bluestein_size_ != 0;
+    }
+
+    size_t WorkSize() const noexcept {
+        return 4 * complex_size_ + 4 * bluestein_size_;
+    }
+
+    const std::vector<Stage>& Stages() const noexcept {
+        return stages_;
+    }
+
+    const T* Twiddle() const noexcept {
+        return twiddle_.data();
+    }
+
+    const T* RealTwiddle() const noexcept {
+        return real_twiddle_.data();
+    }
+
+    /**
+     * @return Bluestein卷积的点数，2的幂，不使用时为0
+     */
+    size_t BluesteinSize() const noexcept {
+        return bluestein_size_;
+    }
+
+    const SimdFFTTable<T>& BluesteinTable() const noexcept {
+        return bluestein_table_;
+    }
+
+    const T* Chirp() const noexcept {
+        return chirp_.data();
+    }
+
+    /**
+     * @param inverse 逆变换使用共轭的chirp
+     */
+    const T* ChirpSpectrum(bool inverse) const noexcept {
+        return inverse ? chirp_spectrum_inverse_.data() : chirp_spectrum_.data();
+    }
+private:
+    size_t complex_size_{};
+    std::vector<Stage> stages_;
+    // 每一级radix-r: w^1 ~ w^(r-1)的实部和虚部，各m = L/r个，radix-4和SimdFFTTable的排列相同
+    std::vector<T> twiddle_;
+    // 实数FFT后处理: exp(-2pi*i*k/n)的实部和虚部，各n/2个
+    std::vector<T> real_twiddle_;
+
+    size_t bluestein_size_{};
+    SimdFFTTable<T> bluestein_table_;
+    // exp(-pi*i*k^2/n)的实部和虚部，各n个
+    std::vector<T> chirp_;
+    // 卷积核的频谱，已经乘以了1/M
+    std::vector<T> chirp_spectrum_;
+    std::vector<T> chirp_spectrum_inverse_;
+};
+
+template<class T>
+void mixed_cdft(int n, int isgn, T* a, const MixedFFTTable<T>& table, T* work) noexcept;
+template<class T>
+void mixed_rdft(int n, int isgn, T* a, const MixedFFTTable<T>& table, T* work) noexcept;
+}
+}
\ No newline at end of file
@@ -0,0 +1,21 @@
+#pragma once
+#include <cstddef>
+
+namespace qwqdsp::spectral::internal {
+
+// --------------------------------------------------------------------------------
+// 频谱的复数乘加
+//
+// 分区卷积的内层循环，x是频谱延迟线，h是IR的各个分区，都是连续存放的split格式
+// 第p个频谱的实部从p * stride开始，虚部从p * stride + stride / 2开始
+// --------------------------------------------------------------------------------
+
+/**
+ * @brief y = sum_{p=0}^{num_partitions-1} x[p] * h[p]，accumulate为true时累加到y上
+ * @param yr yi 各num_bins个
+ */
+void simd_complex_mac(
+    size_t num_bins, size_t num_partitions, size_t stride,
+    const float* x, const float* h, float* yr, float* yi, bool accumulate
+) noexcept;
+}
\ No newline at end of file
@@ -0,0 +1,542 @@
+#pragma once
+#include <cstddef>
+#include <type_traits>
+
+// 定义QWQDSP_FFT_NO_SIMD强制使用标量实现
+#ifndef QWQDSP_FFT_NO_SIMD
+#if defined(__AVX__)
+#include <immintrin.h>
+#define QWQDSP_FFT_HAS_AVX 1
+#endif
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define QWQDSP_FFT_HAS_SSE 1
+#endif
+#endif
+
+// --------------------------------------------------------------------------------
+// simd_fft.cpp、simd_mac.cpp、simd_fir.cpp和fixed_fft.hpp共用的向量操作和蝴蝶
+// 这几个cpp可能单独开了AVX2，和包含本文件的其他翻译单元看到的Ops不同
+// 所以按指令集放进不同的inline namespace，避免同名的inline函数违反ODR
+// --------------------------------------------------------------------------------
+#if defined(QWQDSP_FFT_HAS_AVX) && defined(__FMA__)
+#define QWQDSP_FFT_SIMD_ABI avx_fma
+#elif defined(QWQDSP_FFT_HAS_AVX)
+#define QWQDSP_FFT_SIMD_ABI avx
+#elif defined(QWQDSP_FFT_HAS_SSE)
+#define QWQDSP_FFT_SIMD_ABI sse
+#else
+#define QWQDSP_FFT_SIMD_ABI scalar
+#endif
+
+namespace qwqdsp::spectral::internal {
+inline namespace QWQDSP_FFT_SIMD_ABI {
+template<class T>
+struct ScalarOps {
+    using Scalar = T;
+    using V = T;
+    static constexpr size_t kWidth = 1;
+    static V Load(const T* p) noexcept { return *p; }
+    static void Store(T* p, V v) noexcept { *p = v; }
+    static V Set1(T v) noexcept { return v; }
+    static V Add(V a, V b) noexcept { return a + b; }
+    static V Sub(V a, V b) noexcept { return a - b; }
+    static V Mul(V a, V b) noexcept { return a * b; }
+    // a * b + c
+    static V MulAdd(V a, V b, V c) noexcept { return a * b + c; }
+    // a * b - c
+    static V MulSub(V a, V b, V c) noexcept { return a * b - c; }
+    static V Reverse(V v) noexcept { return v; }
+    static void LoadDeinterleave(const T* p, V& re, V& im) noexcept { re = p[0]; im = p[1]; }
+    static void StoreInterleave(T* p, V re, V im) noexcept { p[0] = re; p[1] = im; }
+};
+
+#ifdef QWQDSP_FFT_HAS_SSE
+template<class T>
+struct SseOps;
+
+template<>
+struct SseOps<float> {
+    using Scalar = float;
+    using V = __m128;
+    static constexpr size_t kWidth = 4;
+    static V Load(const float* p) noexcept { return _mm_loadu_ps(p); }
+    static void Store(float* p, V v) noexcept { _mm_storeu_ps(p, v); }
+    static V Set1(float v) noexcept { return _mm_set1_ps(v); }
+    static V Add(V a, V b) noexcept { return _mm_add_ps(a, b); }
+    static V Sub(V a, V b) noexcept { return _mm_sub_ps(a, b); }
+    static V Mul(V a, V b) noexcept { return _mm_mul_ps(a, b); }
+#ifdef __FMA__
+    static V MulAdd(V a, V b, V c) noexcept { return _mm_fmadd_ps(a, b, c); }
+    static V MulSub(V a, V b, V c) noexcept { return _mm_fmsub_ps(a, b, c); }
+#else
+    static V MulAdd(V a, V b, V c) noexcept { return _mm_add_ps(_mm_mul_ps(a, b), c); }
+    static V MulSub(V a, V b, V c) noexcept { return _mm_sub_ps(_mm_mul_ps(a, b), c); }
+#endif
+    static V Reverse(V v) noexcept { return _mm_shuffle_ps(v, v, _MM_SHUFFLE(0, 1, 2, 3)); }
+    static void LoadDeinterleave(const float* p, V& re, V& im) noexcept {
+        V const v0 = _mm_loadu_ps(p);
+        V const v1 = _mm_loadu_ps(p + 4);
+        re = _mm_shuffle_ps(v0, v1, _MM_SHUFFLE(2, 0, 2, 0));
+        im = _mm_shuffle_ps(v0, v1, _MM_SHUFFLE(3, 1, 3, 1));
+    }
+    static void StoreInterleave(float* p, V re, V im) noexcept {
+        _mm_storeu_ps(p, _mm_unpacklo_ps(re, im));
+        _mm_storeu_ps(p + 4, _mm_unpackhi_ps(re, im));
+    }
+    static void StoreTransposed4(float* p, V v0, V v1, V v2, V v3) noexcept {
+        _MM_TRANSPOSE4_PS(v0, v1, v2, v3);
+        _mm_storeu_ps(p, v0);
+        _mm_storeu_ps(p + 4, v1);
+        _mm_storeu_ps(p + 8, v2);
+        _mm_storeu_ps(p + 12, v3);
+    }
+};
+template<>
+struct SseOps<double> {
+    using Scalar = double;
+    using V = __m128d;
+    static constexpr size_t kWidth = 2;
+    static V Load(const double* p) noexcept { return _mm_loadu_pd(p); }
+    static void Store(double* p, V v) noexcept { _mm_storeu_pd(p, v); }
+    static V Set1(double v) noexcept { return _mm_set1_pd(v); }
+    static V Add(V a, V b) noexcept { return _mm_add_pd(a, b); }
+    static V Sub(V a, V b) noexcept { return _mm_sub_pd(a, b); }
+    static V Mul(V a, V b) noexcept { return _mm_mul_pd(a, b); }
+#ifdef __FMA__
+    static V MulAdd(V a, V b, V c) noexcept { return _mm_fmadd_pd(a, b, c); }
+    static V MulSub(V a, V b, V c) noexcept { return _mm_fmsub_pd(a, b, c); }
+#else
+    static V MulAdd(V a, V b, V c) noexcept { return _mm_add_pd(_mm_mul_pd(a, b), c); }
+    static V MulSub(V a, V b, V c) noexcept { return _mm_sub_pd(_mm_mul_pd(a, b), c); }
+#endif
+    static V Reverse(V v) noexcept { return _mm_shuffle_pd(v, v, 1); }
+    static void LoadDeinterleave(const double* p, V& re, V& im) noexcept {
+        V const v0 = _mm_loadu_pd(p);
+        V const v1 = _mm_loadu_pd(p + 2);
+        re = _mm_unpacklo_pd(v0, v1);
+        im = _mm_unpackhi_pd(v0, v1);
+    }
+    static void StoreInterleave(double* p, V re, V im) noexcept {
+        _mm_storeu_pd(p, _mm_unpacklo_pd(re, im));
+        _mm_storeu_pd(p + 2, _mm_unpackhi_pd(re, im));
+    }
+    static void StoreTransposed4(double* p, V v0, V v1, V v2, V v3) noexcept {
+        _mm_storeu_pd(p, _mm_unpacklo_pd(v0, v1));
+        _mm_storeu_pd(p + 2, _mm_unpacklo_pd(v2, v3));
+        _mm_storeu_pd(p + 4, _mm_unpackhi_pd(v0, v1));
+        _mm_storeu_pd(p + 6, _mm_unpackhi_pd(v2, v3));
+    }
+};
+#endif
+
+#ifdef QWQDSP_FFT_HAS_AVX
+template<class T>
+struct AvxOps;
+
+template<>
+struct AvxOps<float> {
+    using Scalar = float;
+    using V = __m256;
+    static constexpr size_t kWidth = 8;
+    static V Load(const float* p) noexcept { return _mm256_loadu_ps(p); }
+    static void Store(float* p, V v) noexcept { _mm256_storeu_ps(p, v); }
+    static V Set1(float v) noexcept { return _mm256_set1_ps(v); }
+    static V Add(V a, V b) noexcept { return _mm256_add_ps(a, b); }
+    static V Sub(V a, V b) noexcept { return _mm256_sub_ps(a, b); }
+    static V Mul(V a, V b) noexcept { return _mm256_mul_ps(a, b); }
+#ifdef __FMA__
+    static V MulAdd(V a, V b, V c) noexcept { return _mm256_fmadd_ps(a, b, c); }
+    static V MulSub(V a, V b, V c) noexcept { return _mm256_fmsub_ps(a, b, c); }
+#else
+    static V MulAdd(V a, V b, V c) noexcept { return _mm256_add_ps(_mm256_mul_ps(a, b), c); }
+    static V MulSub(V a, V b, V c) noexcept { return _mm256_sub_ps(_mm256_mul_ps(a, b), c); }
+#endif
+    static V Reverse(V v) noexcept {
+        V const swap = _mm256_permute2f128_ps(v, v, 0x01);
+        return _mm256_permute_ps(swap, _MM_SHUFFLE(0, 1, 2, 3));
+    }
+    static void LoadDeinterleave(const float* p, V& re, V& im) noexcept {
+        V const v0 = _mm256_loadu_ps(p);
+        V const v1 = _mm256_loadu_ps(p + 8);
+        V const t0 = _mm256_permute2f128_ps(v0, v1, 0x20);
+        V const t1 = _mm256_permute2f128_ps(v0, v1, 0x31);
+        re = _mm256_shuffle_ps(t0, t1, _MM_SHUFFLE(2, 0, 2, 0));
+        im = _mm256_shuffle_ps(t0, t1, _MM_SHUFFLE(3, 1, 3, 1));
+    }
+    static void StoreInterleave(float* p, V re, V im) noexcept {
+        V const lo = _mm256_unpacklo_ps(re, im);
+        V const hi = _mm256_unpackhi_ps(re, im);
+        _mm256_storeu_ps(p, _mm256_permute2f128_ps(lo, hi, 0x20));
+        _mm256_storeu_ps(p + 8, _mm256_permute2f128_ps(lo, hi, 0x31));
+    }
+};
+
+template<>
+struct AvxOps<double> {
+    using Scalar = double;
+    using V = __m256d;
+    static constexpr size_t kWidth = 4;
+    static V Load(const double* p) noexcept { return _mm256_loadu_pd(p); }
+    static void Store(double* p, V v) noexcept { _mm256_storeu_pd(p, v); }
+    static V Set1(double v) noexcept { return _mm256_set1_pd(v); }
+    static V Add(V a, V b) noexcept { return _mm256_add_pd(a, b); }
+    static V Sub(V a, V b) noexcept { return _mm256_sub_pd(a, b); }
+    static V Mul(V a, V b) noexcept { return _mm256_mul_pd(a, b); }
+#ifdef __FMA__
+    static V MulAdd(V a, V b, V c) noexcept { return _mm256_fmadd_pd(a, b, c); }
+    static V MulSub(V a, V b, V c) noexcept { return _mm256_fmsub_pd(a, b, c); }
+#else
+    static V MulAdd(V a, V b, V c) noexcept { return _mm256_add_pd(_mm256_mul_pd(a, b), c); }
+    static V MulSub(V a, V b, V c) noexcept { return _mm256_sub_pd(_mm256_mul_pd(a, b), c); }
+#endif
+    static V Reverse(V v) noexcept {
+        V const swap = _mm256_permute2f128_pd(v, v, 0x01);
+        return _mm256_permute_pd(swap, 0b0101);
+    }
+    static void LoadDeinterleave(const double* p, V& re, V& im) noexcept {
+        V const v0 = _mm256_loadu_pd(p);
+        V const v1 = _mm256_loadu_pd(p + 4);
+        V const t0 = _mm256_permute2f128_pd(v0, v1, 0x20);
+        V const t1 = _mm256_permute2f128_pd(v0, v1, 0x31);
+        re = _mm256_unpacklo_pd(t0, t1);
+        im = _mm256_unpackhi_pd(t0, t1);
+    }
+    static void StoreInterleave(double* p, V re, V im) noexcept {
+        V const lo = _mm256_unpacklo_pd(re, im);
+        V const hi = _mm256_unpackhi_pd(re, im);
+        _mm256_storeu_pd(p, _mm256_permute2f128_pd(lo, hi, 0x20));
+        _mm256_storeu_pd(p + 4, _mm256_permute2f128_pd(lo, hi, 0x31));
+    }
+    static void StoreTransposed4(double* p, V v0, V v1, V v2, V v3) noexcept {
+        V const t0 = _mm256_unpacklo_pd(v0, v1);
+        V const t1 = _mm256_unpackhi_pd(v0, v1);
+        V const t2 = _mm256_unpacklo_pd(v2, v3);
+        V const t3 = _mm256_unpackhi_pd(v2, v3);
+        _mm256_storeu_pd(p, _mm256_permute2f128_pd(t0, t2, 0x20));
+        _mm256_storeu_pd(p + 4, _mm256_permute2f128_pd(t1, t3, 0x20));
+        _mm256_storeu_pd(p + 8, _mm256_permute2f128_pd(t0, t2, 0x31));
+        _mm256_storeu_pd(p + 12, _mm256_permute2f128_pd(t1, t3, 0x31));
+    }
+};
+#endif
+
+template<class Ops>
+struct Cpx {
+    typename Ops::V re;
+    typename Ops::V im;
+};
+
+/**
+ * @tparam kConj true: x * conj(w)
+ */
+template<class Ops, bool kConj>
+inline Cpx<Ops> MulTwiddle(Cpx<Ops> x, typename Ops::V wr, typename Ops::V wi) noexcept {
+    if constexpr (kConj) {
+        return {
+            Ops::MulAdd(x.re, wr, Ops::Mul(x.im, wi)),
+            Ops::MulSub(x.im, wr, Ops::Mul(x.re, wi))
+        };
+    }
+    else {
+        return {
+            Ops::MulSub(x.re, wr, Ops::Mul(x.im, wi)),
+            Ops::MulAdd(x.im, wr, Ops::Mul(x.re, wi))
+        };
+    }
+}
+
+/**
+ * @brief y0 = a+b+c+d, y1 = w1*(a-c-j(b-d)), y2 = w2*(a+c-b-d), y3 = w3*(a-c+j(b-d))
+ *        逆变换时j取反且旋转因子取共轭
+ */
+template<class Ops, bool kInverse>
+inline void Butterfly4(
+    Cpx<Ops> a, Cpx<Ops> b, Cpx<Ops> c, Cpx<Ops> d,
+    const typename Ops::V* w,
+    Cpx<Ops>& y0, Cpx<Ops>& y1, Cpx<Ops>& y2, Cpx<Ops>& y3
+) noexcept {
+    Cpx<Ops> const apc{Ops::Add(a.re, c.re), Ops::Add(a.im, c.im)};
+    Cpx<Ops> const amc{Ops::Sub(a.re, c.re), Ops::Sub(a.im, c.im)};
+    Cpx<Ops> const bpd{Ops::Add(b.re, d.re), Ops::Add(b.im, d.im)};
+    Cpx<Ops> const bmd{Ops::Sub(b.re, d.re), Ops::Sub(b.im, d.im)};
+    // amc -+ j*bmd
+    Cpx<Ops> const t1{Ops::Add(amc.re, bmd.im), Ops::Sub(amc.im, bmd.re)};
+    Cpx<Ops> const t3{Ops::Sub(amc.re, bmd.im), Ops::Add(amc.im, bmd.re)};
+    Cpx<Ops> const t2{Ops::Sub(apc.re, bpd.re), Ops::Sub(apc.im, bpd.im)};
+    y0 = {Ops::Add(apc.re, bpd.re), Ops::Add(apc.im, bpd.im)};
+    y2 = MulTwiddle<Ops, kInverse>(t2, w[2], w[3]);
+    if constexpr (kInverse) {
+        y1 = MulTwiddle<Ops, true>(t3, w[0], w[1]);
+        y3 = MulTwiddle<Ops, true>(t1, w[4], w[5]);
+    }
+    else {
+        y1 = MulTwiddle<Ops, false>(t1, w[0], w[1]);
+        y3 = MulTwiddle<Ops, false>(t3, w[4], w[5]);
+    }
+}
+
+template<class Ops, class T>
+inline size_t DeinterleaveBody(size_t begin, size_t n, const T* a, T* re, T* im) noexcept {
+    const size_t end = begin + (n - begin) / Ops::kWidth * Ops::kWidth;
+    size_t i = begin;
+    for (; i < end; i += Ops::kWidth) {
+        typename Ops::V r, m;
+        Ops::LoadDeinterleave(a + 2 * i, r, m);
+        Ops::Store(re + i, r);
+        Ops::Store(im + i, m);
+    }
+    return i;
+}
+
+template<class T>
+inline void Deinterleave(size_t n, const T* a, T* re, T* im) noexcept {
+    size_t i = 0;
+#ifdef QWQDSP_FFT_HAS_AVX
+    i = DeinterleaveBody<AvxOps<T>>(i, n, a, re, im);
+#endif
+#ifdef QWQDSP_FFT_HAS_SSE
+    i = DeinterleaveBody<SseOps<T>>(i, n, a, re, im);
+#endif
+    DeinterleaveBody<ScalarOps<T>>(i, n, a, re, im);
+}
+
+template<class Ops, class T>
+inline size_t InterleaveBody(size_t begin, size_t n, const T* re, const T* im, T* a) noexcept {
+    const size_t end = begin + (n - begin) / Ops::kWidth * Ops::kWidth;
+    size_t i = begin;
+    for (; i < end; i += Ops::kWidth) {
+        Ops::StoreInterleave(a + 2 * i, Ops::Load(re + i), Ops::Load(im + i));
+    }
+    return i;
+}
+
+template<class T>
+inline void Interleave(size_t n, const T* re, const T* im, T* a) noexcept {
+    size_t i = 0;
+#ifdef QWQDSP_FFT_HAS_AVX
+    i = InterleaveBody<AvxOps<T>>(i, n, re, im, a);
+#endif
+#ifdef QWQDSP_FFT_HAS_SSE
+    i = InterleaveBody<SseOps<T>>(i, n, re, im, a);
+#endif
+    InterleaveBody<ScalarOps<T>>(i, n, re, im, a);
+}
+
+// --------------------------------------------------------------------------------
+// 实数FFT: n点实数打包成h = n/2点复数 z[k] = x[2k] + i*x[2k+1]
+// 对k和h-k成对处理
+//   正变换: E = (Z[k] + conj(Z[h-k]))/2, O = -i(Z[k] - conj(Z[h-k]))/2, T = W^k*O
+//           X[k] = E + T, X[h-k] = conj(E - T)
+//   逆变换: E = (X[k] + conj(X[h-k]))/2, O = conj(W^k)(X[k] - conj(X[h-k]))/2
+//           Z[k] = E + i*O, Z[h-k] = conj(E - i*O)
+// 频谱有三种存放方式
+//   packed:      oouras的排列, a[0] = X[0], a[1] = X[h], a[2k] = Re, a[2k+1] = -Im
+//   split:       re[k], im[k]，k = 0 ~ h，就是标准的DFT
+//   interleaved: std::complex数组, a[2k] = Re, a[2k+1] = Im，k = 0 ~ h
+// --------------------------------------------------------------------------------
+
+template<class T>
+struct PackedBins {
+    T* a;
+};
+
+template<class T>
+struct SplitBins {
+    T* re;
+    T* im;
+};
+
+template<class T>
+struct ConstSplitBins {
+    const T* re;
+    const T* im;
+};
+
+template<class T>
+struct InterleavedBins {
+    T* a;
+};
+
+template<class T>
+struct ConstInterleavedBins {
+    const T* a;
+};
+
+template<class Ops, class T>
+inline void StoreBins(PackedBins<T> out, size_t k, typename Ops::V re, typename Ops::V im) noexcept {
+    Ops::StoreInterleave(out.a + 2 * k, re, Ops::Sub(Ops::Set1(0.0f), im));
+}
+
+template<class Ops, class T>
+inline void StoreBins(SplitBins<T> out, size_t k, typename Ops::V re, typename Ops::V im) noexcept {
+    Ops::Store(out.re + k, re);
+    Ops::Store(out.im + k, im);
+}
+
+template<class Ops, class T>
+inline void StoreBins(InterleavedBins<T> out, size_t k, typename Ops::V re, typename Ops::V im) noexcept {
+    Ops::StoreInterleave(out.a + 2 * k, re, im);
+}
+
+template<class Ops, class T>
+inline void LoadBins(PackedBins<T> in, size_t k, typename Ops::V& re, typename Ops::V& im) noexcept {
+    Ops::LoadDeinterleave(in.a + 2 * k, re, im);
+    im = Ops::Sub(Ops::Set1(0.0f), im);
+}
+
+template<class Ops, class T>
+inline void LoadBins(ConstSplitBins<T> in, size_t k, typename Ops::V& re, typename Ops::V& im) noexcept {
+    re = Ops::Load(in.re + k);
+    im = Ops::Load(in.im + k);
+}
+
+template<class Ops, class T>
+inline void LoadBins(ConstInterleavedBins<T> in, size_t k, typename Ops::V& re, typename Ops::V& im) noexcept {
+    Ops::LoadDeinterleave(in.a + 2 * k, re, im);
+}
+
+/**
+ * @brief a = Z[k], b = Z[h-k], 输出x = X[k], y = X[h-k]
+ */
+template<class Ops>
+inline void RealForwardPair(Cpx<Ops> a, Cpx<Ops> b, typename Ops::V wr, typename Ops::V wi, Cpx<Ops>& x, Cpx<Ops>& y) noexcept {
+    using V = typename Ops::V;
+    V const half = Ops::Set1(0.5f);
+    // b取共轭
+    V const er = Ops::Mul(half, Ops::Add(a.re, b.re));
+    V const ei = Ops::Mul(half, Ops::Sub(a.im, b.im));
+    V const dr = Ops::Mul(half, Ops::Sub(a.re, b.re));
+    V const di = Ops::Mul(half, Ops::Add(a.im, b.im));
+    // o = -i * d
+    Cpx<Ops> const t = MulTwiddle<Ops, false>({di, Ops::Sub(Ops::Set1(0.0f), dr)}, wr, wi);
+    x = {Ops::Add(er, t.re), Ops::Add(ei, t.im)};
+    y = {Ops::Sub(er, t.re), Ops::Sub(t.im, ei)};
+}
+
+/**
+ * @brief a = X[k], b = X[h-k], 输出x = Z[k], y = Z[h-k]
+ * @param half 0.5 * 输出的增益
+ */
+template<class Ops>
+inline void RealBackwardPair(Cpx<Ops> a, Cpx<Ops> b, typename Ops::V wr, typename Ops::V wi, typename Ops::V half, Cpx<Ops>& x, Cpx<Ops>& y) noexcept {
+    using V = typename Ops::V;
+    // b取共轭
+    V const er = Ops::Mul(half, Ops::Add(a.re, b.re));
+    V const ei = Ops::Mul(half, Ops::Sub(a.im, b.im));
+    V const dr = Ops::Mul(half, Ops::Sub(a.re, b.re));
+    V const di = Ops::Mul(half, Ops::Add(a.im, b.im));
+    Cpx<Ops> const o = MulTwiddle<Ops, true>({dr, di}, wr, wi);
+    x = {Ops::Sub(er, o.im), Ops::Add(ei, o.re)};
+    y = {Ops::Add(er, o.im), Ops::Sub(o.re, ei)};
+}
+
+template<class Ops, class Spectrum, class T>
+inline void RealForwardChunk(
+    size_t k, size_t h, const T* wr, const T* wi,
+    const T* zr, const T* zi, Spectrum out
+) noexcept {
+    const size_t r = h - k - (Ops::kWidth - 1);
+    Cpx<Ops> const a{Ops::Load(zr + k), Ops::Load(zi + k)};
+    Cpx<Ops> const b{Ops::Reverse(Ops::Load(zr + r)), Ops::Reverse(Ops::Load(zi + r))};
+    Cpx<Ops> x, y;
+    RealForwardPair<Ops>(a, b, Ops::Load(wr + k), Ops::Load(wi + k), x, y);
+    StoreBins<Ops>(out, k, x.re, x.im);
+    StoreBins<Ops>(out, r, Ops::Reverse(y.re), Ops::Reverse(y.im));
+}
+
+template<class Spectrum, class T>
+inline void RealForward(size_t h, const T* wr, const T* wi, const T* zr, const T* zi, Spectrum out) noexcept {
+    size_t k = 1;
+#ifdef QWQDSP_FFT_HAS_AVX
+    for (; 2 * k + 2 * AvxOps<T>::kWidth <= h + 1; k += AvxOps<T>::kWidth) {
+        RealForwardChunk<AvxOps<T>>(k, h, wr, wi, zr, zi, out);
+    }
+#endif
+#ifdef QWQDSP_FFT_HAS_SSE
+    for (; 2 * k + 2 * SseOps<T>::kWidth <= h + 1; k += SseOps<T>::kWidth) {
+        RealForwardChunk<SseOps<T>>(k, h, wr, wi, zr, zi, out);
+    }
+#endif
+    // 剩下的包括k == h-k
+    for (; 2 * k <= h; ++k) {
+        RealForwardChunk<ScalarOps<T>>(k, h, wr, wi, zr, zi, out);
+    }
+    T const z0r = zr[0];
+    T const z0i = zi[0];
+    if constexpr (std::is_same_v<Spectrum, PackedBins<T>>) {
+        out.a[0] = z0r + z0i;
+        out.a[1] = z0r - z0i;
+    }
+    else if constexpr (std::is_same_v<Spectrum, InterleavedBins<T>>) {
+        out.a[0] = z0r + z0i;
+        out.a[1] = 0.0f;
+        out.a[2 * h] = z0r - z0i;
+        out.a[2 * h + 1] = 0.0f;
+    }
+    else {
+        out.re[0] = z0r + z0i;
+        out.im[0] = 0.0f;
+        out.re[h] = z0r - z0i;
+        out.im[h] = 0.0f;
+    }
+}
+
+/**
+ * @param scale 输出时域的额外增益
+ */
+template<class Ops, class Spectrum, class T>
+inline void RealBackwardChunk(
+    size_t k, size_t h, const T* wr, const T* wi, T scale,
+    Spectrum in, T* zr, T* zi
+) noexcept {
+    const size_t r = h - k - (Ops::kWidth - 1);
+    Cpx<Ops> a, b;
+    LoadBins<Ops>(in, k, a.re, a.im);
+    LoadBins<Ops>(in, r, b.re, b.im);
+    b.re = Ops::Reverse(b.re);
+    b.im = Ops::Reverse(b.im);
+    Cpx<Ops> x, y;
+    RealBackwardPair<Ops>(a, b, Ops::Load(wr + k), Ops::Load(wi + k), Ops::Set1(0.5f * scale), x, y);
+    Ops::Store(zr + k, x.re);
+    Ops::Store(zi + k, x.im);
+    Ops::Store(zr + r, Ops::Reverse(y.re));
+    Ops::Store(zi + r, Ops::Reverse(y.im));
+}
+
+template<class Spectrum, class T>
+inline void RealBackward(size_t h, const T* wr, const T* wi, T scale, Spectrum in, T* zr, T* zi) noexcept {
+    size_t k = 1;
+#ifdef QWQDSP_FFT_HAS_AVX
+    for (; 2 * k + 2 * AvxOps<T>::kWidth <= h + 1; k += AvxOps<T>::kWidth) {
+        RealBackwardChunk<AvxOps<T>>(k, h, wr, wi, scale, in, zr, zi);
+    }
+#endif
+#ifdef QWQDSP_FFT_HAS_SSE
+    for (; 2 * k + 2 * SseOps<T>::kWidth <= h + 1; k += SseOps<T>::kWidth) {
+        RealBackwardChunk<SseOps<T>>(k, h, wr, wi, scale, in, zr, zi);
+    }
+#endif
+    // 剩下的包括k == h-k
+    for (; 2 * k <= h; ++k) {
+        RealBackwardChunk<ScalarOps<T>>(k, h, wr, wi, scale, in, zr, zi);
+    }
+    T x0;
+    T xh;
+    if constexpr (std::is_same_v<Spectrum, PackedBins<T>>) {
+        x0 = in.a[0];
+        xh = in.a[1];
+    }
+    else if constexpr (std::is_same_v<Spectrum, ConstInterleavedBins<T>>) {
+        x0 = in.a[0];
+        xh = in.a[2 * h];
+    }
+    else {
+        x0 = in.re[0];
+        xh = in.re[h];
+    }
+    zr[0] = 0.5f * scale * (x0 + xh);
+    zi[0] = 0.5f * scale * (x0 - xh);
+}
+}
+}
\ No newline at end of file
@@ -0,0 +1,73 @@
+#pragma once
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <vector>
+
+namespace qwqdsp::spectral {
+/**
+ * @brief split格式的频谱，实部和虚部分开连续存放
+ *        RealFFT写入的是标准DFT X[0] ~ X[N/2]，复数乘加不需要shuffle就能向量化
+ */
+template<class T = float>
+struct SplitSpectrum {
+    std::vector<T> real;
+    std::vector<T> imag;
+
+    void Resize(size_t num_bins) {
+        real.resize(num_bins);
+        imag.resize(num_bins);
+    }
+
+    size_t NumBins() const noexcept {
+        return real.size();
+    }
+
+    void Clear() noexcept {
+        std::fill(real.begin(), real.end(), T{});
+        std::fill(imag.begin(), imag.end(), T{});
+    }
+
+    /**
+     * @brief this = a * b
+     */
+    void Multiply(const SplitSpectrum& a, const SplitSpectrum& b) noexcept {
+        assert(a.NumBins() == NumBins());
+        assert(b.NumBins() == NumBins());
+        const size_t n = NumBins();
+        const T* ar = a.real.data();
+        const T* ai = a.imag.data();
+        const T* br = b.real.data();
+        const T* bi = b.imag.data();
+        T* yr = real.data();
+        T* yi = imag.data();
+        for (size_t i = 0; i < n; ++i) {
+            T const re = ar[i] * br[i] - ai[i] * bi[i];
+            T const im = ar[i] * bi[i] + ai[i] * br[i];
+            yr[i] = re;
+            yi[i] = im;
+        }
+    }
+
+    /**
+     * @brief this += a * b
+     */
+    void MultiplyAccumulate(const SplitSpectrum& a, const SplitSpectrum& b) noexcept {
+        assert(a.NumBins() == NumBins());
+        assert(b.NumBins() == NumBins());
+        const size_t n = NumBins();
+        const T* ar = a.real.data();
+        const T* ai = a.imag.data();
+        const T* br = b.real.data();
+        const T* bi = b.imag.data();
+        T* yr = real.data();
+        T* yi = imag.data();
+        for (size_t i = 0; i < n; ++i) {
+            T const re = ar[i] * br[i] - ai[i] * bi[i];
+            T const im = ar[i] * bi[i] + ai[i] * br[i];
+            yr[i] += re;
+            yi[i] += im;
+        }
+    }
+};
+}
\ No newline at end of file
@@ -0,0 +1,115 @@
+#include "qwqdsp/spectral/fft_plan.hpp"
+
+#include <cmath>
+#include <map>
+#include <mutex>
+#include <tuple>
+
+namespace qwqdsp::spectral {
+namespace internal {
+template<class T>
+void makewt(int nw, int *ip, T *w) noexcept;
+template<class T>
+void makect(int nc, int *ip, T *c) noexcept;
+}
+
+namespace {
+template<class T>
+using PlanKey = std::tuple<size_t, typename FFTPlan<T>::Type, FFTBackend>;
+
+template<class T>
+struct PlanRegistry {
+    std::mutex mutex;
+    std::map<PlanKey<T>, std::weak_ptr<const FFTPlan<T>>> plans;
+};
+
+// float和double各自一个缓存
+template<class T>
+PlanRegistry<T>& GetRegistry() {
+    static PlanRegistry<T> registry;
+    return registry;
+}
+
+size_t OouraIpSize(size_t fft_size) {
+    return 2 + static_cast<size_t>(std::ceil(std::sqrt(fft_size / 2.0f)));
+}
+
+template<class T>
+std::shared_ptr<FFTPlan<T>> MakePlan(size_t fft_size, typename FFTPlan<T>::Type type, FFTBackend backend) {
+    auto plan = std::make_shared<FFTPlan<T>>();
+    plan->fft_size = fft_size;
+    plan->type = type;
+    plan->backend = backend;
+    if (backend == FFTBackend::kSimd) {
+        plan->simd.Init(fft_size, type == FFTPlan<T>::Type::kReal);
+        return plan;
+    }
+    if (backend == FFTBackend::kMixedRadix) {
+        plan->mixed.Init(fft_size, type == FFTPlan<T>::Type::kReal);
+        return plan;
+    }
+
+    std::vector<int> ip(OouraIpSize(fft_size));
+    if (type == FFTPlan<T>::Type::kReal) {
+        const size_t size4 = fft_size / 4;
+        plan->ooura_w.resize(fft_size / 2);
+        internal::makewt(static_cast<int>(size4), ip.data(), plan->ooura_w.data());
+        internal::makect(static_cast<int>(size4), ip.data(), plan->ooura_w.data() + size4);
+    }
+    else if (type == FFTPlan<T>::Type::kDCT) {
+        // ddct/ddst: nw = n/4, nc = n
+        const size_t size4 = fft_size / 4;
+        plan->ooura_w.resize(size4 + fft_size);
+        internal::makewt(static_cast<int>(size4), ip.data(), plan->ooura_w.data());
+        internal::makect(static_cast<int>(fft_size), ip.data(), plan->ooura_w.data() + size4);
+    }
+    else if (type == FFTPlan<T>::Type::kDCTI) {
+        // dfct/dfst: nw = n/8, nc = n/2
+        const size_t size8 = fft_size / 8;
+        plan->ooura_w.resize(size8 + fft_size / 2);
+        internal::makewt(static_cast<int>(size8), ip.data(), plan->ooura_w.data());
+        internal::makect(static_cast<int>(fft_size / 2), ip.data(), plan->ooura_w.data() + size8);
+    }
+    else {
+        const size_t size2 = fft_size / 2;
+        plan->ooura_w.resize(fft_size / 2);
+        internal::makewt(static_cast<int>(size2), ip.data(), plan->ooura_w.data());
+    }
+    plan->ooura_nw = ip[0];
+    plan->ooura_nc = ip[1];
+    return plan;
+}
+}
+
+template<class T>
+std::shared_ptr<const FFTPlan<T>> FFTPlan<T>::Get(size_t fft_size, Type type, FFTBackend backend) {
+    PlanRegistry<T>& registry = GetRegistry<T>();
+    std::lock_guard lock{registry.mutex};
+
+    const PlanKey<T> key{fft_size, type, backend};
+    if (auto it = registry.plans.find(key); it != registry.plans.end()) {
+        if (auto plan = it->second.lock()) {
+            return plan;
+        }
+    }
+
+    // 顺便清理已经没有使用者的表
+    std::erase_if(registry.plans, [](const auto& item) {
+        return item.second.expired();
+    });
+    std::shared_ptr<const FFTPlan<T>> plan = MakePlan<T>(fft_size, type, backend);
+    registry.plans[key] = plan;
+    return plan;
+}
+
+template<class T>
+std::vector<int> FFTPlan<T>::MakeOouraIp() const {
+    std::vector<int> ip(OouraIpSize(fft_size));
+    ip[0] = ooura_nw;
+    ip[1] = ooura_nc;
+    return ip;
+}
+
+template struct FFTPlan<float>;
+template struct FFTPlan<double>;
+}
\ No newline at end of file
@@ -1,10 +1,12 @@
 #include "qwqdsp/filter/fir_design.hpp"
 
+#include <algorithm>
 #include <cassert>
 #include <numbers>
 #include <cmath>
 #include <complex>
-#include <Eigen/Dense>
+#include <limits>
+#include <vector>
 
 static inline double Sinc(double x) {
     [[unlikely]]
@@ -16,130 +18,666 @@ static inline double Sinc(double x) {
     }
 }
 
-namespace qwqdsp::filter {
-// from juce::dsp::FilterDesign
-void FirDesign::LowpassLeastSquare(
-    std::span<float> x,
-    float cutoff,
-    float transist_width, float stop_band_weight
+/**
+ * @brief Levinson递推解对称正定的Toeplitz方程 R x = b，R[i][j] = r[|i - j|]，O(N^2)
+ */
+static void SolveSymmetricToeplitz(
+    const std::vector<double>& r,
+    const std::vector<double>& b,
+    std::vector<double>& x
 ) {
-    
-    double wpass = cutoff - transist_width / 2;
-    double wstop = cutoff + transist_width / 2;
-    int N = static_cast<int>(x.size());
+    const size_t N = r.size();
+    x.assign(N, 0.0);
+    if (N == 0) {
+        return;
+    }
+    // forward是前n阶方程R f = e_0的解，对称矩阵的backward就是它倒过来
+    std::vector<double> forward(N, 0.0);
+    std::vector<double> next(N, 0.0);
+    forward[0] = 1.0 / r[0];
+    x[0] = b[0] / r[0];
+    for (size_t n = 1; n < N; ++n) {
+        // 把forward补0扩展到n + 1阶之后最后一行的误差
+        double error = 0.0;
+        for (size_t i = 0; i < n; ++i) {
+            error += r[n - i] * forward[i];
+        }
+        const double scale = 1.0 / (1.0 - error * error);
+        for (size_t i = 0; i <= n; ++i) {
+            const double f = i < n ? forward[i] : 0.0;
+            const double g = i > 0 ? forward[n - i] : 0.0;
+            next[i] = (f - error * g) * scale;
+        }
+        std::copy_n(next.begin(), n + 1, forward.begin());
 
-    if (N % 2 == 1)
-    {
-        // Type I
-        auto M = (N - 1) / 2;
+        // 用新的backward修正解的最后一行
+        double x_error = 0.0;
+        for (size_t i = 0; i < n; ++i) {
+            x_error += r[n - i] * x[i];
+        }
+        const double gain = b[n] - x_error;
+        for (size_t i = 0; i <= n; ++i) {
+            x[i] += gain * forward[n - i];
+        }
+    }
+}
 
-        Eigen::VectorX<double> b (M + 1);
-        Eigen::VectorX<double> q (2 * M + 1);
+/**
+ * @brief out = R v，R[i][j] = r[|i - j|]，用long double累加
+ */
+static void MultiplySymmetricToeplitz(
+    const std::vector<double>& r,
+    const std::vector<double>& v,
+    std::vector<long double>& out
+) {
+    const size_t N = r.size();
+    for (size_t i = 0; i < N; ++i) {
+        long double sum = 0.0L;
+        for (size_t j = 0; j < N; ++j) {
+            sum += static_cast<long double>(r[i > j ? i - j : j - i]) * v[j];
+        }
+        out[i] = sum;
+    }
+}
 
-        auto factorp = wpass / std::numbers::pi;
-        auto factors = wstop / std::numbers::pi;
+/**
+ * @brief 取 (v + Jv) / 2，J是反转，去掉反对称的部分
+ */
+static void SymmetrizeInPlace(std::vector<double>& v) {
+    const size_t N = v.size();
+    for (size_t i = 0; i < N / 2; ++i) {
+        const double a = (v[i] + v[N - 1 - i]) * 0.5;
+        v[i] = a;
+        v[N - 1 - i] = a;
+    }
+}
 
-        for (int i = 0; i <= M; ++i) {
-            b[i] = factorp * Sinc(factorp * i);
+/**
+ * @brief 重心插值的权重 1 / prod_{j != k} 2(x_k - x_j)
+ *        按间隔交错相乘，几百个点的时候中间结果也不会溢出
+ */
+static void BarycentricWeights(const std::vector<double>& x, std::vector<double>& weights) {
+    const size_t n = x.size();
+    const size_t step = (n - 1) / 15 + 1;
+    weights.resize(n);
+    for (size_t k = 0; k < n; ++k) {
+        double d = 1.0;
+        for (size_t l = 0; l < step; ++l) {
+            for (size_t j = l; j < n; j += step) {
+                if (j != k) {
+                    d *= 2.0 * (x[k] - x[j]);
+                }
+            }
         }
+        weights[k] = 1.0 / d;
+    }
+}
 
-        q[0] = factorp + stop_band_weight * (1.0 - factors);
-        for (int i = 1; i <= 2 * M; ++i) {
-            q[i] = factorp * Sinc(factorp * i) - stop_band_weight * factors * Sinc(factors * i);
+/**
+ * @brief 在x = cos(w)处计算经过(nodes, values)的插值多项式
+ */
+static double BarycentricEval(
+    double x,
+    const std::vector<double>& nodes,
+    const std::vector<double>& values,
+    const std::vector<double>& weights
+) {
+    double num = 0.0;
+    double den = 0.0;
+    for (size_t k = 0; k < nodes.size(); ++k) {
+        const double diff = x - nodes[k];
+        if (std::abs(diff) < 1e-15) {
+            return values[k];
         }
+        const double t = weights[k] / diff;
+        num += t * values[k];
+        den += t;
+    }
+    return num / den;
+}
 
-        // toeplitz
-        Eigen::MatrixX<double> Q(M + 1, M + 1);
-        for (int i = 0; i < M + 1; ++i) {
-            Q(i, i) =  0.5 * q[0];
+/**
+ * @brief 从A(w) = sum_{n=0}^{L} a[n] cos(nw)在w = pi * k / L处的L + 1个采样求系数，DCT-I
+ */
+static std::vector<double> CosineCoeffs(const std::vector<double>& samples) {
+    const size_t num = samples.size();
+    std::vector<double> a(num);
+    if (num == 1) {
+        a[0] = samples[0];
+        return a;
+    }
+    const size_t L = num - 1;
+    for (size_t n = 0; n <= L; ++n) {
+        double sum = 0.0;
+        for (size_t k = 0; k <= L; ++k) {
+            const double v = samples[k] * std::cos(std::numbers::pi * static_cast<double>(n * k % (2 * L)) / static_cast<double>(L));
+            sum += (k == 0 || k == L) ? 0.5 * v : v;
         }
-        for (int i = 1; i < M + 1; ++i) {
-            for (int j = i; j < M + 1; ++j) {
-                Q(j, j - i) = 0.5 * q[i];
-                Q(j - i, j) = 0.5 * q[i];
+        a[n] = sum * 2.0 / static_cast<double>(L);
+    }
+    a[0] *= 0.5;
+    a[L] *= 0.5;
+    return a;
+}
+
+/**
+ * @brief Remez交换的密集格点，过渡带不取点
+ *        偶数长度的期望和权重已经换成D/cos(w/2)和W*cos(w/2)
+ */
+struct RemezGrid {
+    std::vector<double> omega;
+    // cos(omega)
+    std::vector<double> x;
+    std::vector<double> desired;
+    std::vector<double> weight;
+    // 每个点是否是所在频带的第一个/最后一个
+    std::vector<bool> band_first;
+    std::vector<bool> band_last;
+    // 第b个频带是[band_begin[b], band_begin[b + 1])
+    std::vector<size_t> band_begin;
+};
+
+/**
+ * @brief 交换的结果，在nodes上插值就是逼近的多项式
+ */
+struct RemezResult {
+    // r + 1个极值点在格点中的下标
+    std::vector<size_t> extremals;
+    std::vector<double> nodes;
+    std::vector<double> values;
+    std::vector<double> node_weights;
+};
+
+/**
+ * @brief 逼近r - 1次余弦多项式用的格点，间隔是pi / (16r)
+ */
+static RemezGrid MakeRemezGrid(
+    bool odd, size_t r,
+    std::span<const float> bands,
+    std::span<const float> desired,
+    std::span<const float> weights
+) {
+    constexpr size_t kGridDensity = 16;
+    const double spacing = std::numbers::pi / static_cast<double>(kGridDensity * r);
+    RemezGrid grid;
+    for (size_t b = 0; b < desired.size(); ++b) {
+        const double lo = std::clamp(static_cast<double>(bands[2 * b]), 0.0, std::numbers::pi);
+        double hi = std::clamp(static_cast<double>(bands[2 * b + 1]), 0.0, std::numbers::pi);
+        if (!odd) {
+            hi = std::min(hi, std::numbers::pi - spacing);
+        }
+        if (hi < lo) {
+            continue;
+        }
+        grid.band_begin.push_back(grid.x.size());
+        const size_t num = std::max<size_t>(2, static_cast<size_t>(std::ceil((hi - lo) / spacing)) + 1);
+        for (size_t i = 0; i < num; ++i) {
+            const double w = lo + (hi - lo) * static_cast<double>(i) / static_cast<double>(num - 1);
+            double d = desired[b];
+            double wt = weights[b];
+            if (!odd) {
+                const double c = std::cos(w / 2);
+                d /= c;
+                wt *= c;
             }
+            grid.omega.push_back(w);
+            grid.x.push_back(std::cos(w));
+            grid.desired.push_back(d);
+            grid.weight.push_back(wt);
+            grid.band_first.push_back(i == 0);
+            grid.band_last.push_back(i == num - 1);
         }
+    }
+    grid.band_begin.push_back(grid.x.size());
+    return grid;
+}
 
-        // hankel
-        for (int i = 0; i < M + 1; ++i) {
-            Q(i, i) += 0.5 * q[2 * i];
+/**
+ * @brief 每个频带先分一个，剩下的按频带的宽度(格点数)分配，带内均匀分布并包括两端的边缘
+ */
+static void UniformExtremals(const RemezGrid& grid, size_t r, std::vector<size_t>& extremals) {
+    const size_t grid_size = grid.x.size();
+    const size_t num_bands = grid.band_begin.size() - 1;
+    extremals.clear();
+    if (r + 1 < num_bands) {
+        for (size_t k = 0; k <= r; ++k) {
+            extremals.push_back(k * (grid_size - 1) / r);
+        }
+        return;
+    }
+    const size_t rest = r + 1 - num_bands;
+    for (size_t b = 0; b < num_bands; ++b) {
+        const size_t begin = grid.band_begin[b];
+        const size_t num_grid = grid.band_begin[b + 1] - begin;
+        const size_t num = 1 + rest * (begin + num_grid) / grid_size - rest * begin / grid_size;
+        for (size_t j = 0; j < num; ++j) {
+            extremals.push_back(begin + (num == 1 ? (num_grid - 1) / 2 : j * (num_grid - 1) / (num - 1)));
         }
-        for (int i = 1; i < M + 1; ++i) {
-            for (int j = i; j < M + 1; ++j) {
-                Q(j, j - i) += 0.5 * q[i + 2 * (j - i)];
-                Q(j - i, j) += 0.5 * q[i + 2 * (j - i)];
+    }
+}
+
+/**
+ * @brief 把另一个格点上的极值点按频带拉伸成r + 1个，带内对极值点的频率做线性插值
+ * @return 频带对不上或者格点不够时返回false
+ */
+static bool ScaleExtremals(
+    const RemezGrid& from, const std::vector<size_t>& from_extremals,
+    const RemezGrid& to, size_t r,
+    std::vector<size_t>& extremals
+) {
+    if (from.band_begin.size() != to.band_begin.size()) {
+        return false;
+    }
+    const size_t from_total = from_extremals.size();
+    extremals.clear();
+    size_t from_first = 0;
+    for (size_t b = 0; b + 1 < to.band_begin.size(); ++b) {
+        size_t from_last = from_first;
+        while (from_last < from_total && from_extremals[from_last] < from.band_begin[b + 1]) {
+            ++from_last;
+        }
+        const size_t from_num = from_last - from_first;
+        const size_t num = (r + 1) * from_last / from_total - (r + 1) * from_first / from_total;
+        const size_t begin = to.band_begin[b];
+        const size_t end = to.band_begin[b + 1] - 1;
+        if (num > end - begin + 1) {
+            return false;
+        }
+        for (size_t j = 0; j < num; ++j) {
+            const double t = num == 1 ? 0.5 : static_cast<double>(j) / static_cast<double>(num - 1);
+            double w = to.omega[begin] + (to.omega[end] - to.omega[begin]) * t;
+            if (from_num >= 2) {
+                const double u = t * static_cast<double>(from_num - 1);
+                const size_t k = std::min(static_cast<size_t>(u), from_num - 2);
+                const double w0 = from.omega[from_extremals[from_first + k]];
+                const double w1 = from.omega[from_extremals[from_first + k + 1]];
+                w = w0 + (w1 - w0) * (u - static_cast<double>(k));
+            }
+            // 吸附到最近的格点，并给后面的极值点留出位置
+            size_t i = begin;
+            if (end > begin) {
+                const double pos = (w - to.omega[begin]) / (to.omega[end] - to.omega[begin]) * static_cast<double>(end - begin);
+                i = begin + static_cast<size_t>(std::clamp(std::round(pos), 0.0, static_cast<double>(end - begin)));
             }
+            const size_t lower = j == 0 ? begin : extremals.back() + 1;
+            i = std::clamp(i, lower, end - (num - 1 - j));
+            extremals.push_back(i);
         }
+        from_first = from_last;
+    }
+    return extremals.size() == r + 1;
+}
 
-        auto qr = Q.colPivHouseholderQr();
-        auto h = qr.solve(b);
+/**
+ * @brief 插值多项式在格点上的加权误差
+ * @return 最大的绝对值
+ */
+static double RemezError(
+    const RemezGrid& grid,
+    const std::vector<double>& nodes,
+    const std::vector<double>& values,
+    const std::vector<double>& node_weights,
+    std::vector<double>& error
+) {
+    double max_error = 0.0;
+    for (size_t i = 0; i < grid.x.size(); ++i) {
+        error[i] = grid.weight[i] * (grid.desired[i] - BarycentricEval(grid.x[i], nodes, values, node_weights));
+        max_error = std::max(max_error, std::abs(error[i]));
+    }
+    return max_error;
+}
 
-        x[M] = static_cast<float>(h[0]);
-        for (int i = 1; i <= M; ++i) {
-            x[M - i] = static_cast<float>(h(i) * 0.5);
-            x[M + i] = static_cast<float>(h(i) * 0.5);
+/**
+ * @brief Remez交换，result.extremals是初始的极值点
+ * @return 是否收敛，没有收敛时result是最大误差最小的那一次
+ */
+static bool RemezExchange(const RemezGrid& grid, size_t r, size_t max_iterations, RemezResult& result) {
+    const size_t grid_size = grid.x.size();
+    std::vector<size_t> extremals = result.extremals;
+    std::vector<double> nodes(r + 1);
+    std::vector<double> values(r + 1);
+    std::vector<double> node_weights;
+    std::vector<double> error(grid_size);
+    std::vector<size_t> candidates;
+    std::vector<bool> is_extremal(grid_size);
+    double best_error = std::numeric_limits<double>::infinity();
+    bool converged = false;
+    for (size_t iteration = 0; iteration < max_iterations && !converged; ++iteration) {
+        for (size_t k = 0; k <= r; ++k) {
+            nodes[k] = grid.x[extremals[k]];
+        }
+        BarycentricWeights(nodes, node_weights);
+        // 在极值点上误差交替为+-delta
+        double num = 0.0;
+        double den = 0.0;
+        for (size_t k = 0; k <= r; ++k) {
+            const double sign = k % 2 == 0 ? 1.0 : -1.0;
+            num += node_weights[k] * grid.desired[extremals[k]];
+            den += sign * node_weights[k] / grid.weight[extremals[k]];
+        }
+        const double delta = num / den;
+        for (size_t k = 0; k <= r; ++k) {
+            const double sign = k % 2 == 0 ? 1.0 : -1.0;
+            values[k] = grid.desired[extremals[k]] - sign * delta / grid.weight[extremals[k]];
         }
-    }
-    else
-    {
-        // Type II
-        auto M = N / 2;
 
-        Eigen::VectorX<double> b (M);
-        Eigen::VectorX<double> qp (2 * M);
-        Eigen::VectorX<double> qs (2 * M);
+        // delta让插值的最高次项为0，经过r + 1个点的插值就是r - 1次的A(w)
+        const double max_error = RemezError(grid, nodes, values, node_weights, error);
+        if (max_error < best_error) {
+            best_error = max_error;
+            result.extremals = extremals;
+            result.nodes = nodes;
+            result.values = values;
+            result.node_weights = node_weights;
+        }
 
-        auto factorp = wpass / std::numbers::pi;
-        auto factors = wstop / std::numbers::pi;
+        // 新的极值点: 绝对值不小于|delta|的局部极值，频带边缘只和一边比较
+        // 舍入误差让极值点不够r + 1个时，再把频带边缘和上一次的极值点也放进来
+        const double threshold = std::abs(delta) * (1.0 - 1e-9);
+        std::fill(is_extremal.begin(), is_extremal.end(), false);
+        for (size_t k : extremals) {
+            is_extremal[k] = true;
+        }
+        for (bool relaxed : {false, true}) {
+            candidates.clear();
+            for (size_t i = 0; i < grid_size; ++i) {
+                const double e = error[i];
+                const bool keep = relaxed && (grid.band_first[i] || grid.band_last[i] || is_extremal[i]);
+                if (!keep) {
+                    if (std::abs(e) < threshold) {
+                        continue;
+                    }
+                    const bool above_prev = grid.band_first[i] || (e > 0.0 ? e >= error[i - 1] : e <= error[i - 1]);
+                    const bool above_next = grid.band_last[i] || (e > 0.0 ? e >= error[i + 1] : e <= error[i + 1]);
+                    if (!above_prev || !above_next) {
+                        continue;
+                    }
+                }
+                // 同号相邻的只保留更大的，保证正负交替
+                if (!candidates.empty() && (error[candidates.back()] > 0.0) == (e > 0.0)) {
+                    if (std::abs(e) > std::abs(error[candidates.back()])) {
+                        candidates.back() = i;
+                    }
+                    continue;
+                }
+                candidates.push_back(i);
+            }
+            if (candidates.size() >= r + 1) {
+                break;
+            }
+        }
+        if (candidates.size() < r + 1) {
+            break;
+        }
+        // 多出来的从两端去掉较小的，不会破坏交替
+        size_t first = 0;
+        size_t last = candidates.size();
+        while (last - first > r + 1) {
+            if (std::abs(error[candidates[first]]) < std::abs(error[candidates[last - 1]])) {
+                ++first;
+            }
+            else {
+                --last;
+            }
+        }
 
-        for (int i = 0; i < M; ++i) {
-            b[i] = factorp * Sinc(factorp * (i + 0.5));
+        converged = max_error - std::abs(delta) <= 1e-6 * max_error
+            || std::equal(extremals.begin(), extremals.end(), candidates.begin() + static_cast<std::ptrdiff_t>(first));
+        if (converged) {
+            result.extremals = extremals;
+            result.nodes = nodes;
+            result.values = values;
+            result.node_weights = node_weights;
+        }
+        else {
+            std::copy(candidates.begin() + static_cast<std::ptrdiff_t>(first), candidates.begin() + static_cast<std::ptrdiff_t>(last), extremals.begin());
         }
+    }
+    return converged;
+}
 
-        for (int i = 0; i < 2 * M; ++i) {
-            qp[i] = 0.25 * factorp * Sinc(factorp * i);
-            qs[i] = -0.25 * stop_band_weight * factors * Sinc(factors * i);
+/**
+ * @brief 余弦级数sum a[n] cos(nw)在格点上的最大加权误差，Clenshaw递推
+ */
+static double CosineError(const RemezGrid& grid, const std::vector<double>& a) {
+    double max_error = 0.0;
+    for (size_t i = 0; i < grid.x.size(); ++i) {
+        const double x = grid.x[i];
+        double b1 = 0.0;
+        double b2 = 0.0;
+        for (size_t n = a.size(); n-- > 1;) {
+            const double b0 = a[n] + 2.0 * x * b1 - b2;
+            b2 = b1;
+            b1 = b0;
         }
+        const double value = a[0] + x * b1 - b2;
+        max_error = std::max(max_error, std::abs(grid.weight[i] * (grid.desired[i] - value)));
+    }
+    return max_error;
+}
 
-        Eigen::MatrixX<double> Q(M, M);
-        Q.setIdentity();
-        Q *= (0.25 * stop_band_weight);
-        // toeplitz
-        for (int i = 0; i < M; ++i) {
-            Q(i, i) += qp[0];
-            Q(i, i) += qs[0];
+/**
+ * @brief r - 1次余弦多项式的等波纹逼近，系数写到a
+ *        r较小时初始的极值点按频带均匀分布
+ *        长滤波器的插值在过渡带两边是病态的，均匀分布离交替太远，第一次的delta就小到被舍入误差淹没
+ *        所以先解一半长度的问题，把它的极值点按频带拉伸过来(reference scaling)
+ *        再长的时候过渡带里的插值本身也没有精度了，系数不如一半长度的解时就用后者(补0)
+ * @return 是否收敛
+ */
+static bool SolveRemez(
+    bool odd, size_t r,
+    std::span<const float> bands,
+    std::span<const float> desired,
+    std::span<const float> weights,
+    size_t max_iterations,
+    RemezGrid& grid,
+    RemezResult& result,
+    std::vector<double>& a
+) {
+    constexpr size_t kMaxUniformOrder = 64;
+    grid = MakeRemezGrid(odd, r, bands, desired, weights);
+    assert(grid.x.size() > r);
+    std::vector<double> half_a;
+    bool scaled = false;
+    if (r > kMaxUniformOrder) {
+        RemezGrid half_grid;
+        RemezResult half;
+        SolveRemez(odd, r / 2, bands, desired, weights, max_iterations, half_grid, half, half_a);
+        scaled = ScaleExtremals(half_grid, half.extremals, grid, r, result.extremals);
+    }
+    if (!scaled) {
+        UniformExtremals(grid, r, result.extremals);
+    }
+    bool converged = RemezExchange(grid, r, max_iterations, result);
+
+    // 在w = pi * k / (r - 1)处采样插值多项式，换回余弦级数
+    std::vector<double> samples(r);
+    for (size_t k = 0; k < r; ++k) {
+        const double w = r == 1 ? 0.0 : std::numbers::pi * static_cast<double>(k) / static_cast<double>(r - 1);
+        samples[k] = BarycentricEval(std::cos(w), result.nodes, result.values, result.node_weights);
+    }
+    a = CosineCoeffs(samples);
+
+    if (!half_a.empty()) {
+        half_a.resize(r, 0.0);
+        if (CosineError(grid, half_a) < CosineError(grid, a)) {
+            a.swap(half_a);
+            converged = false;
         }
-        for (int i = 1; i < M; ++i) {
-            for (int j = i; j < M; ++j) {
-                Q(j, j - i) += qp[i];
-                Q(j, j - i) += qs[i];
-                Q(j - i, j) += qp[i];
-                Q(j - i, j) += qs[i];
-            }
+    }
+    return converged;
+}
+
+namespace qwqdsp::filter {
+// 加权最小二乘 min (1/pi) int W(w) |H(w) - D(w) e^{-jwc}|^2 dw，通带W = 1，阻带W = stop_band_weight
+// 对整个h求解时法方程是对称正定的Toeplitz矩阵 R[n][m] = r[|n - m|]，解自然是对称的
+// 和只求一半系数的Toeplitz + Hankel方程(juce::dsp::FilterDesign)是同一个最优解，用Levinson预条件的共轭梯度求解，每步O(N^2)
+void FirDesign::LowpassLeastSquare(
+    std::span<float> x,
+    float cutoff,
+    float transist_width, float stop_band_weight
+) {
+    const double wpass = cutoff - transist_width / 2;
+    const double wstop = cutoff + transist_width / 2;
+    const size_t N = x.size();
+    const double factorp = wpass / std::numbers::pi;
+    const double factors = wstop / std::numbers::pi;
+    const double center = (static_cast<double>(N) - 1.0) / 2.0;
+
+    // r[k] = (1/pi) int W(w) cos(kw) dw
+    std::vector<double> r(N);
+    r[0] = factorp + stop_band_weight * (1.0 - factors);
+    for (size_t k = 1; k < N; ++k) {
+        const double t = static_cast<double>(k);
+        r[k] = factorp * Sinc(factorp * t) - stop_band_weight * factors * Sinc(factors * t);
+    }
+
+    // p[n] = (1/pi) int W(w) D(w) cos((n - c)w) dw
+    std::vector<double> p(N);
+    for (size_t n = 0; n < N; ++n) {
+        p[n] = factorp * Sinc(factorp * (static_cast<double>(n) - center));
+    }
+
+    // 过渡带不加权，长的滤波器条件数能到1e15以上，直接Levinson会失去一半以上的精度
+    // 对角线加载只用在预条件上: 加载后的Levinson是R的一个很好的近似逆，
+    // 用它做预条件的共轭梯度去解没有加载的方程，所以加载不会带来偏差
+    // 每一步都投影回对称的子空间，反对称的噪声(就是QR里被截掉的那部分)不会累积
+    // 目标函数 J = h'Rh - 2p'h 用long double算，不再下降就停，不会越迭代越差
+    constexpr double kPreconditionLoading = 1e-10;
+    constexpr size_t kMaxIterations = 32;
+    std::vector<double> loaded = r;
+    loaded[0] *= 1.0 + kPreconditionLoading;
+
+    std::vector<double> h(N);
+    SolveSymmetricToeplitz(loaded, p, h);
+    SymmetrizeInPlace(h);
+
+    std::vector<long double> rh(N);
+    std::vector<double> residual(N);
+    std::vector<double> z(N);
+    std::vector<double> direction(N);
+    std::vector<double> next(N);
+    std::vector<long double> rd(N);
+    MultiplySymmetricToeplitz(r, h, rh);
+    long double objective = 0.0L;
+    for (size_t n = 0; n < N; ++n) {
+        residual[n] = static_cast<double>(p[n] - rh[n]);
+        objective += static_cast<long double>(h[n]) * (rh[n] - 2.0L * p[n]);
+    }
+    SolveSymmetricToeplitz(loaded, residual, z);
+    SymmetrizeInPlace(z);
+    direction = z;
+    long double rz = 0.0L;
+    for (size_t n = 0; n < N; ++n) {
+        rz += static_cast<long double>(residual[n]) * z[n];
+    }
+
+    for (size_t iter = 0; iter < kMaxIterations; ++iter) {
+        MultiplySymmetricToeplitz(r, direction, rd);
+        long double curvature = 0.0L;
+        for (size_t n = 0; n < N; ++n) {
+            curvature += direction[n] * rd[n];
+        }
+        if (!(curvature > 0.0L)) {
+            break;
+        }
+        const long double alpha = rz / curvature;
+        for (size_t n = 0; n < N; ++n) {
+            next[n] = static_cast<double>(h[n] + alpha * direction[n]);
+        }
+        MultiplySymmetricToeplitz(r, next, rh);
+        long double next_objective = 0.0L;
+        for (size_t n = 0; n < N; ++n) {
+            next_objective += static_cast<long double>(next[n]) * (rh[n] - 2.0L * p[n]);
         }
+        if (!(next_objective < objective)) {
+            break;
+        }
+        objective = next_objective;
+        h.swap(next);
 
-        // hankel
-        for (int i = 0; i < M; ++i) {
-            Q(i, i) += qp[2 * i + 1];
-            Q(i, i) += qs[2 * i + 1];
+        for (size_t n = 0; n < N; ++n) {
+            residual[n] = static_cast<double>(p[n] - rh[n]);
         }
-        for (int i = 1; i < M; ++i) {
-            for (int j = i; j < M; ++j) {
-                Q(j, j - i) += qp[i + 1 + 2 * (j - i)];
-                Q(j - i, j) += qp[i + 1 + 2 * (j - i)];
-                Q(j, j - i) += qs[i + 1 + 2 * (j - i)];
-                Q(j - i, j) += qs[i + 1 + 2 * (j - i)];
-            }
+        SolveSymmetricToeplitz(loaded, residual, z);
+        SymmetrizeInPlace(z);
+        long double next_rz = 0.0L;
+        for (size_t n = 0; n < N; ++n) {
+            next_rz += static_cast<long double>(residual[n]) * z[n];
         }
+        const long double beta = next_rz / rz;
+        rz = next_rz;
+        for (size_t n = 0; n < N; ++n) {
+            direction[n] = static_cast<double>(z[n] + beta * direction[n]);
+        }
+    }
+    for (size_t n = 0; n < N; ++n) {
+        x[n] = static_cast<float>(h[n]);
+    }
+}
 
-        auto qr = Q.colPivHouseholderQr();
-        auto h = qr.solve(b);
+// Parks-McClellan, 在x = cos(w)上做Remez交换
+bool FirDesign::Remez(
+    std::span<float> x,
+    std::span<const float> bands,
+    std::span<const float> desired,
+    std::span<const float> weights,
+    size_t max_iterations
+) {
+    assert(!x.empty());
+    assert(bands.size() % 2 == 0);
+    assert(desired.size() == bands.size() / 2);
+    assert(weights.size() == bands.size() / 2);
+
+    // 奇数长度 A(w) = sum_{n=0}^{r-1} a[n] cos(nw)
+    // 偶数长度 A(w) = cos(w/2) * P(w)，对P做逼近，期望和权重换成D/cos(w/2)和W*cos(w/2)
+    const size_t N = x.size();
+    const bool odd = N % 2 == 1;
+    const size_t r = odd ? (N - 1) / 2 + 1 : N / 2;
 
-        for (int i = 0; i < M; ++i) {
-            x[M - i - 1] = static_cast<float> (h[i] * 0.25);
-            x[M + i]     = static_cast<float> (h[i] * 0.25);
+    RemezGrid grid;
+    RemezResult result;
+    std::vector<double> a;
+    const bool converged = SolveRemez(odd, r, bands, desired, weights, max_iterations, grid, result, a);
+
+    if (odd) {
+        // Type I, h[c +- n] = a[n] / 2
+        const size_t c = r - 1;
+        x[c] = static_cast<float>(a[0]);
+        for (size_t n = 1; n < r; ++n) {
+            x[c - n] = static_cast<float>(a[n] * 0.5);
+            x[c + n] = static_cast<float>(a[n] * 0.5);
+        }
+    }
+    else {
+        // Type II, cos(w/2)cos(nw) = (cos((n+1/2)w) + cos((n-1/2)w)) / 2
+        // A(w) = sum_{m=1}^{r} 2h[r-m] cos((m-1/2)w)
+        for (size_t m = 1; m <= r; ++m) {
+            double c = 0.5 * a[m - 1];
+            if (m < r) {
+                c += 0.5 * a[m];
+            }
+            if (m == 1) {
+                c += 0.5 * a[0];
+            }
+            x[r - m] = static_cast<float>(c * 0.5);
+            x[r - 1 + m] = static_cast<float>(c * 0.5);
         }
     }
+    return converged;
+}
+
+bool FirDesign::LowpassRemez(
+    std::span<float> x,
+    float cutoff,
+    float transist_width, float stop_band_weight
+) {
+    const float wpass = std::max(0.0f, cutoff - transist_width / 2);
+    const float wstop = std::min(std::numbers::pi_v<float>, cutoff + transist_width / 2);
+    const float bands[]{0.0f, wpass, wstop, std::numbers::pi_v<float>};
+    const float desired[]{1.0f, 0.0f};
+    const float weights[]{1.0f, stop_band_weight};
+    return Remez(x, bands, desired, weights);
 }
 
 void FirDesign::GainResponce(std::span<float> coeffs, std::span<float> gains) {
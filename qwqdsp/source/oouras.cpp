@@ -7,26 +7,45 @@
 // Please refer to this package when you modify this code.
 // --------------------------------------------------------------------------------
 namespace qwqdsp::spectral::internal {
-void cdft(int, int, float *, int *, float *) noexcept;
-void rdft(int, int, float *, int *, float *) noexcept;
-void ddct(int, int, float *, int *, float *) noexcept;
-void ddst(int, int, float *, int *, float *) noexcept;
-void bitrv2(int n, int *ip, float *a) noexcept;
-void bitrv2conj(int n, int *ip, float *a) noexcept;
-void cftfsub(int n, float *a, float *w) noexcept;
-void cftbsub(int n, float *a, float *w) noexcept;
-void cft1st(int n, float *a, float *w) noexcept;
-void makewt(int nw, int *ip, float *w) noexcept;
-void makect(int nc, int *ip, float *c) noexcept;
-void dfct(int, float *, float *, int *, float *) noexcept;
-void dfst(int, float *, float *, int *, float *) noexcept;
-void rftfsub(int n, float *a, int nc, float *c) noexcept;
-void rftbsub(int n, float *a, int nc, float *c) noexcept;
-void dctsub(int n, float *a, int nc, float *c) noexcept;
-void dstsub(int n, float *a, int nc, float *c) noexcept;
-void cftmdl(int n, int l, float *a, float *w) noexcept;
+template<class T>
+void cdft(int, int, T *, int *, T *) noexcept;
+template<class T>
+void rdft(int, int, T *, int *, T *) noexcept;
+template<class T>
+void ddct(int, int, T *, int *, T *) noexcept;
+template<class T>
+void ddst(int, int, T *, int *, T *) noexcept;
+template<class T>
+void bitrv2(int n, int *ip, T *a) noexcept;
+template<class T>
+void bitrv2conj(int n, int *ip, T *a) noexcept;
+template<class T>
+void cftfsub(int n, T *a, T *w) noexcept;
+template<class T>
+void cftbsub(int n, T *a, T *w) noexcept;
+template<class T>
+void cft1st(int n, T *a, T *w) noexcept;
+template<class T>
+void makewt(int nw, int *ip, T *w) noexcept;
+template<class T>
+void makect(int nc, int *ip, T *c) noexcept;
+template<class T>
+void dfct(int, T *, T *, int *, T *) noexcept;
+template<class T>
+void dfst(int, T *, T *, int *, T *) noexcept;
+template<class T>
+void rftfsub(int n, T *a, int nc, T *c) noexcept;
+template<class T>
+void rftbsub(int n, T *a, int nc, T *c) noexcept;
+template<class T>
+void dctsub(int n, T *a, int nc, T *c) noexcept;
+template<class T>
+void dstsub(int n, T *a, int nc, T *c) noexcept;
+template<class T>
+void cftmdl(int n, int l, T *a, T *w) noexcept;
 
-void cdft(int n, int isgn, float *a, int *ip, float *w) noexcept
+template<class T>
+void cdft(int n, int isgn, T *a, int *ip, T *w) noexcept
 {
     if (n > 4) {
         if (isgn >= 0) {
@@ -42,7 +61,8 @@ void cdft(int n, int isgn, float *a, int *ip, float *w) noexcept
 }
 
 
-void rdft(int n, int isgn, float *a, int *ip, float *w) noexcept
+template<class T>
+void rdft(int n, int isgn, T *a, int *ip, T *w) noexcept
 {
     int nw = ip[0];
     int nc = ip[1];
@@ -54,7 +74,7 @@ void rdft(int n, int isgn, float *a, int *ip, float *w) noexcept
         } else if (n == 4) {
             cftfsub(n, a, w);
         }
-        float xi = a[0] - a[1];
+        T xi = a[0] - a[1];
         a[0] += a[1];
         a[1] = xi;
     } else {
@@ -71,10 +91,11 @@ void rdft(int n, int isgn, float *a, int *ip, float *w) noexcept
 }
 
 
-void ddct(int n, int isgn, float *a, int *ip, float *w) noexcept
+template<class T>
+void ddct(int n, int isgn, T *a, int *ip, T *w) noexcept
 {
     int j, nw, nc;
-    float xr;
+    T xr;
     
     nw = ip[0];
     if (n > (nw << 2)) {
@@ -122,10 +143,11 @@ void ddct(int n, int isgn, float *a, int *ip, float *w) noexcept
 }
 
 
-void ddst(int n, int isgn, float *a, int *ip, float *w) noexcept
+template<class T>
+void ddst(int n, int isgn, T *a, int *ip, T *w) noexcept
 {
     int j, nw, nc;
-    float xr;
+    T xr;
     
     nw = ip[0];
     if (n > (nw << 2)) {
@@ -173,10 +195,11 @@ void ddst(int n, int isgn, float *a, int *ip, float *w) noexcept
 }
 
 
-void dfct(int n, float *a, float *t, int *ip, float *w) noexcept
+template<class T>
+void dfct(int n, T *a, T *t, int *ip, T *w) noexcept
 {
     int j, k, l, m, mh, nw, nc;
-    float xr, xi, yr, yi;
+    T xr, xi, yr, yi;
     
     nw = ip[0];
     if (n > (nw << 3)) {
@@ -263,10 +286,11 @@ void dfct(int n, float *a, float *t, int *ip, float *w) noexcept
 }
 
 
-void dfst(int n, float *a, float *t, int *ip, float *w) noexcept
+template<class T>
+void dfst(int n, T *a, T *t, int *ip, T *w) noexcept
 {
     int j, k, l, m, mh, nw, nc;
-    float xr, xi, yr, yi;
+    T xr, xi, yr, yi;
     
     nw = ip[0];
     if (n > (nw << 3)) {
@@ -349,10 +373,11 @@ void dfst(int n, float *a, float *t, int *ip, float *w) noexcept
 
 #include <math.h>
 
-void makewt(int nw, int *ip, float *w) noexcept
+template<class T>
+void makewt(int nw, int *ip, T *w) noexcept
 {
     int j, nwh;
-    float delta, x, y;
+    T delta, x, y;
     
     ip[0] = nw;
     ip[1] = 1;
@@ -378,10 +403,11 @@ void makewt(int nw, int *ip, float *w) noexcept
 }
 
 
-void makect(int nc, int *ip, float *c) noexcept
+template<class T>
+void makect(int nc, int *ip, T *c) noexcept
 {
     int j, nch;
-    float delta;
+    T delta;
     
     ip[1] = nc;
     if (nc > 1) {
@@ -400,10 +426,11 @@ void makect(int nc, int *ip, float *c) noexcept
 /* -------- child routines -------- */
 
 
-void bitrv2(int n, int *ip, float *a) noexcept
+template<class T>
+void bitrv2(int n, int *ip, T *a) noexcept
 {
     int j, j1, k, k1, l, m, m2;
-    float xr, xi, yr, yi;
+    T xr, xi, yr, yi;
     
     ip[0] = 0;
     l = n;
@@ -500,10 +527,11 @@ void bitrv2(int n, int *ip, float *a) noexcept
 }
 
 
-void bitrv2conj(int n, int *ip, float *a) noexcept
+template<class T>
+void bitrv2conj(int n, int *ip, T *a) noexcept
 {
     int j, j1, k, k1, l, m, m2;
-    float xr, xi, yr, yi;
+    T xr, xi, yr, yi;
     
     ip[0] = 0;
     l = n;
@@ -609,10 +637,11 @@ void bitrv2conj(int n, int *ip, float *a) noexcept
 }
 
 
-void cftfsub(int n, float *a, float *w) noexcept
+template<class T>
+void cftfsub(int n, T *a, T *w) noexcept
 {
     int j, j1, j2, j3, l;
-    float x0r, x0i, x1r, x1i, x2r, x2i, x3r, x3i;
+    T x0r, x0i, x1r, x1i, x2r, x2i, x3r, x3i;
     
     l = 2;
     if (n > 8) {
@@ -659,10 +688,11 @@ void cftfsub(int n, float *a, float *w) noexcept
 }
 
 
-void cftbsub(int n, float *a, float *w) noexcept
+template<class T>
+void cftbsub(int n, T *a, T *w) noexcept
 {
     int j, j1, j2, j3, l;
-    float x0r, x0i, x1r, x1i, x2r, x2i, x3r, x3i;
+    T x0r, x0i, x1r, x1i, x2r, x2i, x3r, x3i;
     
     l = 2;
     if (n > 8) {
@@ -708,11 +738,12 @@ void cftbsub(int n, float *a, float *w) noexcept
     }
 }
 
-void cft1st(int n, float *a, float *w) noexcept
+template<class T>
+void cft1st(int n, T *a, T *w) noexcept
 {
     int j, k1, k2;
-    float wk1r, wk1i, wk2r, wk2i, wk3r, wk3i;
-    float x0r, x0i, x1r, x1i, x2r, x2i, x3r, x3i;
+    T wk1r, wk1i, wk2r, wk2i, wk3r, wk3i;
+    T x0r, x0i, x1r, x1i, x2r, x2i, x3r, x3i;
     
     x0r = a[0] + a[2];
     x0i = a[1] + a[3];
@@ -813,11 +844,12 @@ void cft1st(int n, float *a, float *w) noexcept
 }
 
 
-void cftmdl(int n, int l, float *a, float *w) noexcept
+template<class T>
+void cftmdl(int n, int l, T *a, T *w) noexcept
 {
     int j, j1, j2, j3, k, k1, k2, m, m2;
-    float wk1r, wk1i, wk2r, wk2i, wk3r, wk3i;
-    float x0r, x0i, x1r, x1i, x2r, x2i, x3r, x3i;
+    T wk1r, wk1i, wk2r, wk2i, wk3r, wk3i;
+    T x0r, x0i, x1r, x1i, x2r, x2i, x3r, x3i;
     
     m = l << 2;
     for (j = 0; j < l; j += 2) {
@@ -940,10 +972,11 @@ void cftmdl(int n, int l, float *a, float *w) noexcept
 }
 
 
-void rftfsub(int n, float *a, int nc, float *c) noexcept
+template<class T>
+void rftfsub(int n, T *a, int nc, T *c) noexcept
 {
     int j, k, kk, ks, m;
-    float wkr, wki, xr, xi, yr, yi;
+    T wkr, wki, xr, xi, yr, yi;
     
     m = n >> 1;
     ks = 2 * nc / m;
@@ -965,10 +998,11 @@ void rftfsub(int n, float *a, int nc, float *c) noexcept
 }
 
 
-void rftbsub(int n, float *a, int nc, float *c) noexcept
+template<class T>
+void rftbsub(int n, T *a, int nc, T *c) noexcept
 {
     int j, k, kk, ks, m;
-    float wkr, wki, xr, xi, yr, yi;
+    T wkr, wki, xr, xi, yr, yi;
     
     a[1] = -a[1];
     m = n >> 1;
@@ -992,10 +1026,11 @@ void rftbsub(int n, float *a, int nc, float *c) noexcept
 }
 
 
-void dctsub(int n, float *a, int nc, float *c) noexcept
+template<class T>
+void dctsub(int n, T *a, int nc, T *c) noexcept
 {
     int j, k, kk, ks, m;
-    float wkr, wki, xr;
+    T wkr, wki, xr;
     
     m = n >> 1;
     ks = nc / n;
@@ -1013,10 +1048,11 @@ void dctsub(int n, float *a, int nc, float *c) noexcept
 }
 
 
-void dstsub(int n, float *a, int nc, float *c) noexcept
+template<class T>
+void dstsub(int n, T *a, int nc, T *c) noexcept
 {
     int j, k, kk, ks, m;
-    float wkr, wki, xr;
+    T wkr, wki, xr;
     
     m = n >> 1;
     ks = nc / n;
@@ -1032,4 +1068,18 @@ void dstsub(int n, float *a, int nc, float *c) noexcept
     }
     a[m] *= c[0];
 }
-}
+
+#define QWQDSP_OOURA_INSTANTIATE(T) \
+    template void cdft<T>(int, int, T *, int *, T *) noexcept; \
+    template void rdft<T>(int, int, T *, int *, T *) noexcept; \
+    template void ddct<T>(int, int, T *, int *, T *) noexcept; \
+    template void ddst<T>(int, int, T *, int *, T *) noexcept; \
+    template void dfct<T>(int, T *, T *, int *, T *) noexcept; \
+    template void dfst<T>(int, T *, T *, int *, T *) noexcept; \
+    template void makewt<T>(int, int *, T *) noexcept; \
+    template void makect<T>(int, int *, T *) noexcept;
+
+QWQDSP_OOURA_INSTANTIATE(float)
+QWQDSP_OOURA_INSTANTIATE(double)
+#undef QWQDSP_OOURA_INSTANTIATE
+}
\ No newline at end of file
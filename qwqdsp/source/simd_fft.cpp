@@ -0,0 +1,1047 @@
+#include "qwqdsp/spectral/simd_fft.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <numbers>
+#include <type_traits>
+#include <utility>
+
+#include "qwqdsp/spectral/simd_ops.hpp"
+
+// --------------------------------------------------------------------------------
+// radix-4 Stockham自动排序FFT，数据是split格式(实部和虚部分开存放)
+// 第一级stride为1，在p方向向量化然后4x4转置写回，之后stride>=4，直接在q方向向量化
+// 点数为2的奇数次幂时最后补一级radix-2
+// --------------------------------------------------------------------------------
+namespace qwqdsp::spectral::internal {
+namespace {
+/**
+ * @brief 在q方向(stride内)向量化的radix-4，要求s是向量宽度的整数倍
+ */
+template<class Ops, bool kInverse, class T>
+void Radix4Strided(
+    size_t len, size_t s, const T* tw,
+    const T* xr, const T* xi, T* yr, T* yi
+) noexcept {
+    using V = typename Ops::V;
+    const size_t m = len / 4;
+    for (size_t p = 0; p < m; ++p) {
+        V const w[6]{
+            Ops::Set1(tw[p]), Ops::Set1(tw[m + p]),
+            Ops::Set1(tw[2 * m + p]), Ops::Set1(tw[3 * m + p]),
+            Ops::Set1(tw[4 * m + p]), Ops::Set1(tw[5 * m + p])
+        };
+        const size_t xa = s * p;
+        const size_t xb = s * (p + m);
+        const size_t xc = s * (p + 2 * m);
+        const size_t xd = s * (p + 3 * m);
+        const size_t y0 = s * (4 * p);
+        for (size_t q = 0; q < s; q += Ops::kWidth) {
+            Cpx<Ops> const a{Ops::Load(xr + xa + q), Ops::Load(xi + xa + q)};
+            Cpx<Ops> const b{Ops::Load(xr + xb + q), Ops::Load(xi + xb + q)};
+            Cpx<Ops> const c{Ops::Load(xr + xc + q), Ops::Load(xi + xc + q)};
+            Cpx<Ops> const d{Ops::Load(xr + xd + q), Ops::Load(xi + xd + q)};
+            Cpx<Ops> o0, o1, o2, o3;
+            Butterfly4<Ops, kInverse>(a, b, c, d, w, o0, o1, o2, o3);
+            Ops::Store(yr + y0 + q, o0.re);
+            Ops::Store(yi + y0 + q, o0.im);
+            Ops::Store(yr + y0 + s + q, o1.re);
+            Ops::Store(yi + y0 + s + q, o1.im);
+            Ops::Store(yr + y0 + 2 * s + q, o2.re);
+            Ops::Store(yi + y0 + 2 * s + q, o2.im);
+            Ops::Store(yr + y0 + 3 * s + q, o3.re);
+            Ops::Store(yi + y0 + 3 * s + q, o3.im);
+        }
+    }
+}
+
+/**
+ * @brief s == 1的第一级，在p方向向量化，要求m是向量宽度的整数倍
+ *        Ops需要提供StoreTransposed4，把4个输出转置之后连续写入
+ */
+template<class Ops, bool kInverse, class T>
+void Radix4First(
+    size_t len, const T* tw,
+    const T* xr, const T* xi, T* yr, T* yi
+) noexcept {
+    using V = typename Ops::V;
+    const size_t m = len / 4;
+    for (size_t p = 0; p < m; p += Ops::kWidth) {
+        V const w[6]{
+            Ops::Load(tw + p), Ops::Load(tw + m + p),
+            Ops::Load(tw + 2 * m + p), Ops::Load(tw + 3 * m + p),
+            Ops::Load(tw + 4 * m + p), Ops::Load(tw + 5 * m + p)
+        };
+        Cpx<Ops> const a{Ops::Load(xr + p), Ops::Load(xi + p)};
+        Cpx<Ops> const b{Ops::Load(xr + p + m), Ops::Load(xi + p + m)};
+        Cpx<Ops> const c{Ops::Load(xr + p + 2 * m), Ops::Load(xi + p + 2 * m)};
+        Cpx<Ops> const d{Ops::Load(xr + p + 3 * m), Ops::Load(xi + p + 3 * m)};
+        Cpx<Ops> o0, o1, o2, o3;
+        Butterfly4<Ops, kInverse>(a, b, c, d, w, o0, o1, o2, o3);
+        Ops::StoreTransposed4(yr + 4 * p, o0.re, o1.re, o2.re, o3.re);
+        Ops::StoreTransposed4(yi + 4 * p, o0.im, o1.im, o2.im, o3.im);
+    }
+}
+
+template<bool kInverse, class T>
+void Radix4(
+    size_t len, size_t s, const T* tw,
+    const T* xr, const T* xi, T* yr, T* yi
+) noexcept {
+#ifdef QWQDSP_FFT_HAS_AVX
+    if (s % AvxOps<T>::kWidth == 0) {
+        Radix4Strided<AvxOps<T>, kInverse>(len, s, tw, xr, xi, yr, yi);
+        return;
+    }
+    // float的AVX宽度为8，第一级仍然用SSE
+    if constexpr (std::is_same_v<T, double>) {
+        if (s == 1 && len % (4 * AvxOps<T>::kWidth) == 0) {
+            Radix4First<AvxOps<T>, kInverse>(len, tw, xr, xi, yr, yi);
+            return;
+        }
+    }
+#endif
+#ifdef QWQDSP_FFT_HAS_SSE
+    if (s % SseOps<T>::kWidth == 0) {
+        Radix4Strided<SseOps<T>, kInverse>(len, s, tw, xr, xi, yr, yi);
+        return;
+    }
+    if (s == 1 && len % (4 * SseOps<T>::kWidth) == 0) {
+        Radix4First<SseOps<T>, kInverse>(len, tw, xr, xi, yr, yi);
+        return;
+    }
+#endif
+    Radix4Strided<ScalarOps<T>, kInverse>(len, s, tw, xr, xi, yr, yi);
+}
+
+template<class Ops, class T>
+void Radix2Strided(size_t s, const T* xr, const T* xi, T* yr, T* yi) noexcept {
+    for (size_t q = 0; q < s; q += Ops::kWidth) {
+        auto const ar = Ops::Load(xr + q);
+        auto const ai = Ops::Load(xi + q);
+        auto const br = Ops::Load(xr + s + q);
+        auto const bi = Ops::Load(xi + s + q);
+        Ops::Store(yr + q, Ops::Add(ar, br));
+        Ops::Store(yi + q, Ops::Add(ai, bi));
+        Ops::Store(yr + s + q, Ops::Sub(ar, br));
+        Ops::Store(yi + s + q, Ops::Sub(ai, bi));
+    }
+}
+
+template<class T>
+void Radix2(size_t s, const T* xr, const T* xi, T* yr, T* yi) noexcept {
+#ifdef QWQDSP_FFT_HAS_AVX
+    if (s % AvxOps<T>::kWidth == 0) {
+        Radix2Strided<AvxOps<T>>(s, xr, xi, yr, yi);
+        return;
+    }
+#endif
+#ifdef QWQDSP_FFT_HAS_SSE
+    if (s % SseOps<T>::kWidth == 0) {
+        Radix2Strided<SseOps<T>>(s, xr, xi, yr, yi);
+        return;
+    }
+#endif
+    Radix2Strided<ScalarOps<T>>(s, xr, xi, yr, yi);
+}
+
+/**
+ * @brief 数据从x开始，在x和y之间来回
+ * @param s 初始stride，批处理时多个通道交错存放，stride就是通道数
+ * @return true: 结果在y中
+ */
+template<bool kInverse, class T>
+bool Stockham(
+    size_t n, size_t s, const T* tw,
+    T* xr, T* xi, T* yr, T* yi
+) noexcept {
+    bool in_y = false;
+    size_t len = n;
+    while (len >= 4) {
+        Radix4<kInverse>(len, s, tw, xr, xi, yr, yi);
+        tw += 6 * (len / 4);
+        std::swap(xr, yr);
+        std::swap(xi, yi);
+        in_y = !in_y;
+        len /= 4;
+        s *= 4;
+    }
+    if (len == 2) {
+        Radix2(s, xr, xi, yr, yi);
+        in_y = !in_y;
+    }
+    return in_y;
+}
+
+// --------------------------------------------------------------------------------
+// 批处理: 第k个点的第c个通道在k * kSimdBatchLanes + c，按通道方向向量化
+// --------------------------------------------------------------------------------
+
+#if defined(QWQDSP_FFT_HAS_AVX)
+using LaneOps = AvxOps<float>;
+#elif defined(QWQDSP_FFT_HAS_SSE)
+using LaneOps = SseOps<float>;
+#else
+using LaneOps = ScalarOps<float>;
+#endif
+static_assert(kSimdBatchLanes % LaneOps::kWidth == 0);
+
+void RealForwardBatch(size_t h, const float* wr, const float* wi, float* zr, float* zi) noexcept {
+    constexpr size_t kLanes = kSimdBatchLanes;
+    for (size_t k = 1; 2 * k <= h; ++k) {
+        const size_t r = h - k;
+        auto const twr = LaneOps::Set1(wr[k]);
+        auto const twi = LaneOps::Set1(wi[k]);
+        for (size_t c = 0; c < kLanes; c += LaneOps::kWidth) {
+            Cpx<LaneOps> const a{LaneOps::Load(zr + k * kLanes + c), LaneOps::Load(zi + k * kLanes + c)};
+            Cpx<LaneOps> const b{LaneOps::Load(zr + r * kLanes + c), LaneOps::Load(zi + r * kLanes + c)};
+            Cpx<LaneOps> x, y;
+            RealForwardPair<LaneOps>(a, b, twr, twi, x, y);
+            LaneOps::Store(zr + k * kLanes + c, x.re);
+            LaneOps::Store(zi + k * kLanes + c, x.im);
+            LaneOps::Store(zr + r * kLanes + c, y.re);
+            LaneOps::Store(zi + r * kLanes + c, y.im);
+        }
+    }
+}
+
+/**
+ * @brief 进入时z[0]的实部是X[0]，虚部是X[h]
+ */
+void RealBackwardBatch(size_t h, const float* wr, const float* wi, float scale, float* zr, float* zi) noexcept {
+    constexpr size_t kLanes = kSimdBatchLanes;
+    auto const half = LaneOps::Set1(0.5f * scale);
+    for (size_t k = 1; 2 * k <= h; ++k) {
+        const size_t r = h - k;
+        auto const twr = LaneOps::Set1(wr[k]);
+        auto const twi = LaneOps::Set1(wi[k]);
+        for (size_t c = 0; c < kLanes; c += LaneOps::kWidth) {
+            Cpx<LaneOps> const a{LaneOps::Load(zr + k * kLanes + c), LaneOps::Load(zi + k * kLanes + c)};
+            Cpx<LaneOps> const b{LaneOps::Load(zr + r * kLanes + c), LaneOps::Load(zi + r * kLanes + c)};
+            Cpx<LaneOps> x, y;
+            RealBackwardPair<LaneOps>(a, b, twr, twi, half, x, y);
+            LaneOps::Store(zr + k * kLanes + c, x.re);
+            LaneOps::Store(zi + k * kLanes + c, x.im);
+            LaneOps::Store(zr + r * kLanes + c, y.re);
+            LaneOps::Store(zi + r * kLanes + c, y.im);
+        }
+    }
+    for (size_t c = 0; c < kLanes; c += LaneOps::kWidth) {
+        auto const x0 = LaneOps::Load(zr + c);
+        auto const xh = LaneOps::Load(zi + c);
+        LaneOps::Store(zr + c, LaneOps::Mul(half, LaneOps::Add(x0, xh)));
+        LaneOps::Store(zi + c, LaneOps::Mul(half, LaneOps::Sub(x0, xh)));
+    }
+}
+
+/**
+ * @brief 没有用到的通道填0，避免对垃圾数据做运算
+ */
+void ClearUnusedLanes(size_t n, size_t count, float* xr, float* xi) noexcept {
+    for (size_t c = count; c < kSimdBatchLanes; ++c) {
+        for (size_t k = 0; k < n; ++k) {
+            xr[k * kSimdBatchLanes + c] = 0.0f;
+            xi[k * kSimdBatchLanes + c] = 0.0f;
+        }
+    }
+}
+
+#ifdef QWQDSP_FFT_HAS_AVX
+static_assert(kSimdBatchLanes == AvxOps<float>::kWidth);
+
+/**
+ * @brief r[i]的第j个元素和r[j]的第i个元素交换
+ */
+inline void Transpose8x8(__m256* r) noexcept {
+    __m256 const t0 = _mm256_unpacklo_ps(r[0], r[1]);
+    __m256 const t1 = _mm256_unpackhi_ps(r[0], r[1]);
+    __m256 const t2 = _mm256_unpacklo_ps(r[2], r[3]);
+    __m256 const t3 = _mm256_unpackhi_ps(r[2], r[3]);
+    __m256 const t4 = _mm256_unpacklo_ps(r[4], r[5]);
+    __m256 const t5 = _mm256_unpackhi_ps(r[4], r[5]);
+    __m256 const t6 = _mm256_unpacklo_ps(r[6], r[7]);
+    __m256 const t7 = _mm256_unpackhi_ps(r[6], r[7]);
+    __m256 const s0 = _mm256_shuffle_ps(t0, t2, _MM_SHUFFLE(1, 0, 1, 0));
+    __m256 const s1 = _mm256_shuffle_ps(t0, t2, _MM_SHUFFLE(3, 2, 3, 2));
+    __m256 const s2 = _mm256_shuffle_ps(t1, t3, _MM_SHUFFLE(1, 0, 1, 0));
+    __m256 const s3 = _mm256_shuffle_ps(t1, t3, _MM_SHUFFLE(3, 2, 3, 2));
+    __m256 const s4 = _mm256_shuffle_ps(t4, t6, _MM_SHUFFLE(1, 0, 1, 0));
+    __m256 const s5 = _mm256_shuffle_ps(t4, t6, _MM_SHUFFLE(3, 2, 3, 2));
+    __m256 const s6 = _mm256_shuffle_ps(t5, t7, _MM_SHUFFLE(1, 0, 1, 0));
+    __m256 const s7 = _mm256_shuffle_ps(t5, t7, _MM_SHUFFLE(3, 2, 3, 2));
+    r[0] = _mm256_permute2f128_ps(s0, s4, 0x20);
+    r[1] = _mm256_permute2f128_ps(s1, s5, 0x20);
+    r[2] = _mm256_permute2f128_ps(s2, s6, 0x20);
+    r[3] = _mm256_permute2f128_ps(s3, s7, 0x20);
+    r[4] = _mm256_permute2f128_ps(s0, s4, 0x31);
+    r[5] = _mm256_permute2f128_ps(s1, s5, 0x31);
+    r[6] = _mm256_permute2f128_ps(s2, s6, 0x31);
+    r[7] = _mm256_permute2f128_ps(s3, s7, 0x31);
+}
+#endif
+
+/**
+ * @brief 交错复数 -> 批处理排列，第k个点从in[c][(k + rotate) % n]读取
+ */
+void GatherInterleaved(size_t n, size_t count, const float* const* in, size_t rotate, float* xr, float* xi) noexcept {
+    constexpr size_t kLanes = kSimdBatchLanes;
+    rotate %= n;
+#ifdef QWQDSP_FFT_HAS_AVX
+    if (count == kLanes && n % kLanes == 0 && rotate % kLanes == 0) {
+        for (size_t k = 0; k < n; k += kLanes) {
+            const size_t idx = (k + rotate) % n;
+            __m256 re[kLanes];
+            __m256 im[kLanes];
+            for (size_t c = 0; c < kLanes; ++c) {
+                AvxOps<float>::LoadDeinterleave(in[c] + 2 * idx, re[c], im[c]);
+            }
+            Transpose8x8(re);
+            Transpose8x8(im);
+            for (size_t j = 0; j < kLanes; ++j) {
+                AvxOps<float>::Store(xr + (k + j) * kLanes, re[j]);
+                AvxOps<float>::Store(xi + (k + j) * kLanes, im[j]);
+            }
+        }
+        return;
+    }
+#endif
+    // k在外层，写入是连续的
+    size_t idx = rotate;
+    for (size_t k = 0; k < n; ++k) {
+        for (size_t c = 0; c < count; ++c) {
+            xr[k * kLanes + c] = in[c][2 * idx];
+            xi[k * kLanes + c] = in[c][2 * idx + 1];
+        }
+        idx = idx + 1 == n ? 0 : idx + 1;
+    }
+    ClearUnusedLanes(n, count, xr, xi);
+}
+
+/**
+ * @brief 批处理排列 -> 交错复数，第k个点乘以scale写入out[c][(k + rotate) % n]
+ */
+void ScatterInterleaved(size_t n, size_t count, const float* xr, const float* xi, float* const* out, size_t rotate, float scale) noexcept {
+    constexpr size_t kLanes = kSimdBatchLanes;
+    rotate %= n;
+#ifdef QWQDSP_FFT_HAS_AVX
+    if (count == kLanes && n % kLanes == 0 && rotate % kLanes == 0) {
+        __m256 const g = AvxOps<float>::Set1(scale);
+        for (size_t k = 0; k < n; k += kLanes) {
+            const size_t idx = (k + rotate) % n;
+            __m256 re[kLanes];
+            __m256 im[kLanes];
+            for (size_t j = 0; j < kLanes; ++j) {
+                re[j] = AvxOps<float>::Mul(g, AvxOps<float>::Load(xr + (k + j) * kLanes));
+                im[j] = AvxOps<float>::Mul(g, AvxOps<float>::Load(xi + (k + j) * kLanes));
+            }
+            Transpose8x8(re);
+            Transpose8x8(im);
+            for (size_t c = 0; c < kLanes; ++c) {
+                AvxOps<float>::StoreInterleave(out[c] + 2 * idx, re[c], im[c]);
+            }
+        }
+        return;
+    }
+#endif
+    size_t idx = rotate;
+    for (size_t k = 0; k < n; ++k) {
+        for (size_t c = 0; c < count; ++c) {
+            out[c][2 * idx] = xr[k * kLanes + c] * scale;
+            out[c][2 * idx + 1] = xi[k * kLanes + c] * scale;
+        }
+        idx = idx + 1 == n ? 0 : idx + 1;
+    }
+}
+
+/**
+ * @brief split频谱的前n个bin -> 批处理排列
+ */
+void GatherSplit(size_t n, size_t count, const float* const* re, const float* const* im, float* xr, float* xi) noexcept {
+    constexpr size_t kLanes = kSimdBatchLanes;
+    size_t k = 0;
+#ifdef QWQDSP_FFT_HAS_AVX
+    if (count == kLanes) {
+        for (; k + kLanes <= n; k += kLanes) {
+            __m256 vr[kLanes];
+            __m256 vi[kLanes];
+            for (size_t c = 0; c < kLanes; ++c) {
+                vr[c] = AvxOps<float>::Load(re[c] + k);
+                vi[c] = AvxOps<float>::Load(im[c] + k);
+            }
+            Transpose8x8(vr);
+            Transpose8x8(vi);
+            for (size_t j = 0; j < kLanes; ++j) {
+                AvxOps<float>::Store(xr + (k + j) * kLanes, vr[j]);
+                AvxOps<float>::Store(xi + (k + j) * kLanes, vi[j]);
+            }
+        }
+    }
+#endif
+    for (; k < n; ++k) {
+        for (size_t c = 0; c < count; ++c) {
+            xr[k * kLanes + c] = re[c][k];
+            xi[k * kLanes + c] = im[c][k];
+        }
+    }
+    ClearUnusedLanes(n, count, xr, xi);
+}
+
+/**
+ * @brief 批处理排列 -> split频谱的前n个bin
+ */
+void ScatterSplit(size_t n, size_t count, const float* xr, const float* xi, float* const* re, float* const* im) noexcept {
+    constexpr size_t kLanes = kSimdBatchLanes;
+    size_t k = 0;
+#ifdef QWQDSP_FFT_HAS_AVX
+    if (count == kLanes) {
+        for (; k + kLanes <= n; k += kLanes) {
+            __m256 vr[kLanes];
+            __m256 vi[kLanes];
+            for (size_t j = 0; j < kLanes; ++j) {
+                vr[j] = AvxOps<float>::Load(xr + (k + j) * kLanes);
+                vi[j] = AvxOps<float>::Load(xi + (k + j) * kLanes);
+            }
+            Transpose8x8(vr);
+            Transpose8x8(vi);
+            for (size_t c = 0; c < kLanes; ++c) {
+                AvxOps<float>::Store(re[c] + k, vr[c]);
+                AvxOps<float>::Store(im[c] + k, vi[c]);
+            }
+        }
+    }
+#endif
+    for (; k < n; ++k) {
+        for (size_t c = 0; c < count; ++c) {
+            re[c][k] = xr[k * kLanes + c];
+            im[c][k] = xi[k * kLanes + c];
+        }
+    }
+}
+
+// --------------------------------------------------------------------------------
+// mixed radix: 每一级x[q + s(p + t*m)] -> r点DFT -> 第k个输出乘w^(pk) -> y[q + s(r*p + k)]
+// 奇数radix把t和r-t成对计算
+//   A_k = x0 + sum cos(2pi*tk/r)(x_t + x_(r-t)), B_k = sum sin(2pi*tk/r)(x_t - x_(r-t))
+//   y_k = A_k -+ i*B_k, y_(r-k) = A_k +- i*B_k
+// --------------------------------------------------------------------------------
+
+template<size_t kRadix>
+struct OddRadixConstant {
+    static constexpr size_t kHalf = (kRadix - 1) / 2;
+    // cos(2pi*j/r), sin(2pi*j/r), j = 0 ~ (r-1)/2
+    static constexpr double kCos3[2]{1.0, -0.5};
+    static constexpr double kSin3[2]{0.0, 0.866025403784438647};
+    static constexpr double kCos5[3]{1.0, 0.309016994374947424, -0.809016994374947424};
+    static constexpr double kSin5[3]{0.0, 0.951056516295153572, 0.587785252292473129};
+    static constexpr double kCos7[4]{1.0, 0.623489801858733531, -0.222520933956314404, -0.900968867902419126};
+    static constexpr double kSin7[4]{0.0, 0.781831482468029809, 0.974927912181823607, 0.433883739117558120};
+
+    static constexpr double Cos(size_t j) noexcept {
+        j %= kRadix;
+        if (j > kHalf) {
+            j = kRadix - j;
+        }
+        if constexpr (kRadix == 3) return kCos3[j];
+        else if constexpr (kRadix == 5) return kCos5[j];
+        else return kCos7[j];
+    }
+
+    static constexpr double Sin(size_t j) noexcept {
+        j %= kRadix;
+        double sign = 1.0;
+        if (j > kHalf) {
+            j = kRadix - j;
+            sign = -1.0;
+        }
+        if constexpr (kRadix == 3) return sign * kSin3[j];
+        else if constexpr (kRadix == 5) return sign * kSin5[j];
+        else return sign * kSin7[j];
+    }
+};
+
+template<class Ops, bool kInverse, size_t kRadix>
+inline void ButterflyOdd(const Cpx<Ops>* x, Cpx<Ops>* y) noexcept {
+    using C = OddRadixConstant<kRadix>;
+    constexpr size_t kHalf = C::kHalf;
+    Cpx<Ops> sum[kHalf];
+    Cpx<Ops> diff[kHalf];
+    Cpx<Ops> y0 = x[0];
+    for (size_t t = 1; t <= kHalf; ++t) {
+        sum[t - 1] = {Ops::Add(x[t].re, x[kRadix - t].re), Ops::Add(x[t].im, x[kRadix - t].im)};
+        diff[t - 1] = {Ops::Sub(x[t].re, x[kRadix - t].re), Ops::Sub(x[t].im, x[kRadix - t].im)};
+        y0 = {Ops::Add(y0.re, sum[t - 1].re), Ops::Add(y0.im, sum[t - 1].im)};
+    }
+    y[0] = y0;
+    for (size_t k = 1; k <= kHalf; ++k) {
+        Cpx<Ops> a = x[0];
+        Cpx<Ops> b{Ops::Set1(0.0f), Ops::Set1(0.0f)};
+        for (size_t t = 1; t <= kHalf; ++t) {
+            using T = typename Ops::Scalar;
+            auto const c = Ops::Set1(static_cast<T>(C::Cos(t * k)));
+            auto const sn = Ops::Set1(static_cast<T>(C::Sin(t * k)));
+            a = {Ops::MulAdd(c, sum[t - 1].re, a.re), Ops::MulAdd(c, sum[t - 1].im, a.im)};
+            b = {Ops::MulAdd(sn, diff[t - 1].re, b.re), Ops::MulAdd(sn, diff[t - 1].im, b.im)};
+        }
+        // 正变换: y_k = a - i*b
+        if constexpr (kInverse) {
+            y[k] = {Ops::Sub(a.re, b.im), Ops::Add(a.im, b.re)};
+            y[kRadix - k] = {Ops::Add(a.re, b.im), Ops::Sub(a.im, b.re)};
+        }
+        else {
+            y[k] = {Ops::Add(a.re, b.im), Ops::Sub(a.im, b.re)};
+            y[kRadix - k] = {Ops::Sub(a.re, b.im), Ops::Add(a.im, b.re)};
+        }
+    }
+}
+
+/**
+ * @brief 在q方向向量化的radix-2/3/5/7，要求s是向量宽度的整数倍
+ */
+template<class Ops, bool kInverse, size_t kRadix, class T>
+void RadixNStrided(
+    size_t len, size_t s, const T* tw,
+    const T* xr, const T* xi, T* yr, T* yi
+) noexcept {
+    using V = typename Ops::V;
+    const size_t m = len / kRadix;
+    for (size_t p = 0; p < m; ++p) {
+        V w[2 * (kRadix - 1)];
+        for (size_t k = 0; k < 2 * (kRadix - 1); ++k) {
+            w[k] = Ops::Set1(tw[k * m + p]);
+        }
+        const size_t y0 = s * (kRadix * p);
+        for (size_t q = 0; q < s; q += Ops::kWidth) {
+            Cpx<Ops> x[kRadix];
+            for (size_t t = 0; t < kRadix; ++t) {
+                const size_t idx = s * (p + t * m) + q;
+                x[t] = {Ops::Load(xr + idx), Ops::Load(xi + idx)};
+            }
+            Cpx<Ops> y[kRadix];
+            if constexpr (kRadix == 2) {
+                y[0] = {Ops::Add(x[0].re, x[1].re), Ops::Add(x[0].im, x[1].im)};
+                y[1] = {Ops::Sub(x[0].re, x[1].re), Ops::Sub(x[0].im, x[1].im)};
+            }
+            else {
+                ButterflyOdd<Ops, kInverse, kRadix>(x, y);
+            }
+            Ops::Store(yr + y0 + q, y[0].re);
+            Ops::Store(yi + y0 + q, y[0].im);
+            for (size_t k = 1; k < kRadix; ++k) {
+                Cpx<Ops> const o = MulTwiddle<Ops, kInverse>(y[k], w[2 * k - 2], w[2 * k - 1]);
+                Ops::Store(yr + y0 + k * s + q, o.re);
+                Ops::Store(yi + y0 + k * s + q, o.im);
+            }
+        }
+    }
+}
+
+template<bool kInverse, size_t kRadix, class T>
+void RadixN(
+    size_t len, size_t s, const T* tw,
+    const T* xr, const T* xi, T* yr, T* yi
+) noexcept {
+#ifdef QWQDSP_FFT_HAS_AVX
+    if (s % AvxOps<T>::kWidth == 0) {
+        RadixNStrided<AvxOps<T>, kInverse, kRadix>(len, s, tw, xr, xi, yr, yi);
+        return;
+    }
+#endif
+#ifdef QWQDSP_FFT_HAS_SSE
+    if (s % SseOps<T>::kWidth == 0) {
+        RadixNStrided<SseOps<T>, kInverse, kRadix>(len, s, tw, xr, xi, yr, yi);
+        return;
+    }
+#endif
+    RadixNStrided<ScalarOps<T>, kInverse, kRadix>(len, s, tw, xr, xi, yr, yi);
+}
+
+/**
+ * @return true: 结果在y中
+ */
+template<bool kInverse, class T>
+bool MixedStockham(
+    const MixedFFTTable<T>& table,
+    T* xr, T* xi, T* yr, T* yi
+) noexcept {
+    const T* tw = table.Twiddle();
+    bool in_y = false;
+    size_t s = 1;
+    for (auto const& stage : table.Stages()) {
+        switch (stage.radix) {
+        case 2:
+            RadixN<kInverse, 2>(stage.len, s, tw, xr, xi, yr, yi);
+            break;
+        case 3:
+            RadixN<kInverse, 3>(stage.len, s, tw, xr, xi, yr, yi);
+            break;
+        case 4:
+            Radix4<kInverse>(stage.len, s, tw, xr, xi, yr, yi);
+            break;
+        case 5:
+            RadixN<kInverse, 5>(stage.len, s, tw, xr, xi, yr, yi);
+            break;
+        default:
+            RadixN<kInverse, 7>(stage.len, s, tw, xr, xi, yr, yi);
+            break;
+        }
+        tw += 2 * (stage.radix - 1) * (stage.len / stage.radix);
+        std::swap(xr, yr);
+        std::swap(xi, yi);
+        in_y = !in_y;
+        s *= stage.radix;
+    }
+    return in_y;
+}
+
+/**
+ * @brief y = a * w，kConj为true时乘w的共轭
+ */
+template<class Ops, bool kConj, class T>
+size_t MultiplyBody(
+    size_t begin, size_t n, const T* ar, const T* ai, const T* wr, const T* wi,
+    T* yr, T* yi
+) noexcept {
+    size_t i = begin;
+    for (; i + Ops::kWidth <= n; i += Ops::kWidth) {
+        Cpx<Ops> const y = MulTwiddle<Ops, kConj>({Ops::Load(ar + i), Ops::Load(ai + i)}, Ops::Load(wr + i), Ops::Load(wi + i));
+        Ops::Store(yr + i, y.re);
+        Ops::Store(yi + i, y.im);
+    }
+    return i;
+}
+
+template<bool kConj, class T>
+void Multiply(
+    size_t n, const T* ar, const T* ai, const T* wr, const T* wi,
+    T* yr, T* yi
+) noexcept {
+    size_t i = 0;
+#ifdef QWQDSP_FFT_HAS_AVX
+    i = MultiplyBody<AvxOps<T>, kConj>(i, n, ar, ai, wr, wi, yr, yi);
+#endif
+#ifdef QWQDSP_FFT_HAS_SSE
+    i = MultiplyBody<SseOps<T>, kConj>(i, n, ar, ai, wr, wi, yr, yi);
+#endif
+    MultiplyBody<ScalarOps<T>, kConj>(i, n, ar, ai, wr, wi, yr, yi);
+}
+
+/**
+ * @brief Bluestein: X[k] = c[k] * sum x[j]c[j]conj(c[k-j])，c[k] = exp(-pi*i*k^2/n)
+ *        卷积用M点的2的幂FFT，逆变换时c取共轭
+ * @param extra 4M个float
+ */
+template<bool kInverse, class T>
+void Bluestein(
+    const MixedFFTTable<T>& table,
+    const T* xr, const T* xi, T* yr, T* yi, T* extra
+) noexcept {
+    const size_t n = table.ComplexSize();
+    const size_t big = table.BluesteinSize();
+    const T* cr = table.Chirp();
+    const T* ci = cr + n;
+    const T* sr = table.ChirpSpectrum(kInverse);
+    const T* si = sr + big;
+    T* ar = extra;
+    T* ai = extra + big;
+    T* br = extra + 2 * big;
+    T* bi = extra + 3 * big;
+    Multiply<kInverse>(n, xr, xi, cr, ci, ar, ai);
+    std::fill(ar + n, ar + big, 0.0f);
+    std::fill(ai + n, ai + big, 0.0f);
+    if (Stockham<false>(big, 1, table.BluesteinTable().Twiddle(), ar, ai, br, bi)) {
+        std::swap(ar, br);
+        std::swap(ai, bi);
+    }
+    Multiply<false>(big, ar, ai, sr, si, ar, ai);
+    if (Stockham<true>(big, 1, table.BluesteinTable().Twiddle(), ar, ai, br, bi)) {
+        std::swap(ar, br);
+        std::swap(ai, bi);
+    }
+    Multiply<kInverse>(n, ar, ai, cr, ci, yr, yi);
+}
+
+/**
+ * @brief 数据从x开始
+ * @param extra Bluestein使用的额外工作区
+ * @return true: 结果在y中
+ */
+template<bool kInverse, class T>
+bool MixedCore(
+    const MixedFFTTable<T>& table,
+    T* xr, T* xi, T* yr, T* yi, T* extra
+) noexcept {
+    if (table.UseBluestein()) {
+        Bluestein<kInverse>(table, xr, xi, yr, yi, extra);
+        return true;
+    }
+    return MixedStockham<kInverse>(table, xr, xi, yr, yi);
+}
+
+/**
+ * @param core bool(T* xr, T* xi, T* yr, T* yi)，h点复数正变换，返回true表示结果在y中
+ */
+template<class Spectrum, class Core, class T>
+void RealFFTForward(size_t n, const T* time, Spectrum out, const T* real_twiddle, Core core, T* work) noexcept {
+    const size_t h = n / 2;
+    const T* wr = real_twiddle;
+    const T* wi = wr + h;
+    T* xr = work;
+    T* xi = work + h;
+    T* yr = work + 2 * h;
+    T* yi = work + 3 * h;
+    Deinterleave(h, time, xr, xi);
+    if (core(xr, xi, yr, yi)) {
+        RealForward(h, wr, wi, yr, yi, out);
+    }
+    else {
+        RealForward(h, wr, wi, xr, xi, out);
+    }
+}
+
+/**
+ * @param core h点复数逆变换
+ */
+template<class Spectrum, class Core, class T>
+void RealFFTBackward(size_t n, Spectrum in, T* time, T scale, const T* real_twiddle, Core core, T* work) noexcept {
+    const size_t h = n / 2;
+    const T* wr = real_twiddle;
+    const T* wi = wr + h;
+    T* xr = work;
+    T* xi = work + h;
+    T* yr = work + 2 * h;
+    T* yi = work + 3 * h;
+    RealBackward(h, wr, wi, scale, in, xr, xi);
+    if (core(xr, xi, yr, yi)) {
+        Interleave(h, yr, yi, time);
+    }
+    else {
+        Interleave(h, xr, xi, time);
+    }
+}
+
+template<class Spectrum, class T>
+void RealFFTForward(size_t n, const T* time, Spectrum out, const SimdFFTTable<T>& table, T* work) noexcept {
+    RealFFTForward(n, time, out, table.RealTwiddle(), [&](T* xr, T* xi, T* yr, T* yi) {
+        return Stockham<false>(n / 2, 1, table.Twiddle(), xr, xi, yr, yi);
+    }, work);
+}
+
+template<class Spectrum, class T>
+void RealFFTBackward(size_t n, Spectrum in, T* time, T scale, const SimdFFTTable<T>& table, T* work) noexcept {
+    RealFFTBackward(n, in, time, scale, table.RealTwiddle(), [&](T* xr, T* xi, T* yr, T* yi) {
+        return Stockham<true>(n / 2, 1, table.Twiddle(), xr, xi, yr, yi);
+    }, work);
+}
+}
+
+template<class T>
+void SimdFFTTable<T>::Init(size_t n, bool real) {
+    complex_size_ = real ? n / 2 : n;
+
+    size_t num_twiddle = 0;
+    for (size_t len = complex_size_; len >= 4; len /= 4) {
+        num_twiddle += 6 * (len / 4);
+    }
+    twiddle_.resize(num_twiddle);
+    T* tw = twiddle_.data();
+    for (size_t len = complex_size_; len >= 4; len /= 4) {
+        const size_t m = len / 4;
+        const double theta = 2.0 * std::numbers::pi / static_cast<double>(len);
+        for (size_t p = 0; p < m; ++p) {
+            for (size_t j = 1; j <= 3; ++j) {
+                const double phase = theta * static_cast<double>(j * p);
+                tw[(2 * j - 2) * m + p] = static_cast<T>(std::cos(phase));
+                tw[(2 * j - 1) * m + p] = static_cast<T>(-std::sin(phase));
+            }
+        }
+        tw += 6 * m;
+    }
+
+    if (real) {
+        const size_t h = n / 2;
+        real_twiddle_.resize(2 * h);
+        const double theta = 2.0 * std::numbers::pi / static_cast<double>(n);
+        for (size_t k = 0; k < h; ++k) {
+            real_twiddle_[k] = static_cast<T>(std::cos(theta * static_cast<double>(k)));
+            real_twiddle_[h + k] = static_cast<T>(-std::sin(theta * static_cast<double>(k)));
+        }
+    }
+    else {
+        real_twiddle_.clear();
+    }
+}
+
+template<class T>
+void simd_cdft(int n, int isgn, T* a, const SimdFFTTable<T>& table, T* work) noexcept {
+    const size_t cn = static_cast<size_t>(n / 2);
+    T* xr = work;
+    T* xi = work + cn;
+    T* yr = work + 2 * cn;
+    T* yi = work + 3 * cn;
+    Deinterleave(cn, a, xr, xi);
+    // oouras的isgn >= 0是exp(+i)
+    bool const in_y = isgn >= 0
+        ? Stockham<true>(cn, 1, table.Twiddle(), xr, xi, yr, yi)
+        : Stockham<false>(cn, 1, table.Twiddle(), xr, xi, yr, yi);
+    if (in_y) {
+        Interleave(cn, yr, yi, a);
+    }
+    else {
+        Interleave(cn, xr, xi, a);
+    }
+}
+
+template<class T>
+void simd_rdft(int n, int isgn, T* a, const SimdFFTTable<T>& table, T* work) noexcept {
+    if (isgn >= 0) {
+        RealFFTForward(static_cast<size_t>(n), a, PackedBins<T>{a}, table, work);
+    }
+    else {
+        RealFFTBackward(static_cast<size_t>(n), PackedBins<T>{a}, a, T(1), table, work);
+    }
+}
+
+template<class T>
+void simd_rdft_split(int n, const T* time, T* re, T* im, const SimdFFTTable<T>& table, T* work) noexcept {
+    RealFFTForward(static_cast<size_t>(n), time, SplitBins<T>{re, im}, table, work);
+}
+
+template<class T>
+void simd_irdft_split(int n, const T* re, const T* im, T* time, const SimdFFTTable<T>& table, T* work) noexcept {
+    RealFFTBackward(static_cast<size_t>(n), ConstSplitBins<T>{re, im}, time, T(2) / static_cast<T>(n), table, work);
+}
+
+void simd_rdft_batch(
+    int n, size_t count, const float* const* time, float* const* re, float* const* im,
+    const SimdFFTTable<float>& table, float* work
+) noexcept {
+    constexpr size_t kLanes = kSimdBatchLanes;
+    const size_t h = static_cast<size_t>(n / 2);
+    float* xr = work;
+    float* xi = work + h * kLanes;
+    float* yr = work + 2 * h * kLanes;
+    float* yi = work + 3 * h * kLanes;
+    GatherInterleaved(h, count, time, 0, xr, xi);
+    if (Stockham<false>(h, kLanes, table.Twiddle(), xr, xi, yr, yi)) {
+        std::swap(xr, yr);
+        std::swap(xi, yi);
+    }
+    const float* wr = table.RealTwiddle();
+    RealForwardBatch(h, wr, wr + h, xr, xi);
+    ScatterSplit(h, count, xr, xi, re, im);
+    for (size_t c = 0; c < count; ++c) {
+        re[c][0] = xr[c] + xi[c];
+        im[c][0] = 0.0f;
+        re[c][h] = xr[c] - xi[c];
+        im[c][h] = 0.0f;
+    }
+}
+
+void simd_irdft_batch(
+    int n, size_t count, const float* const* re, const float* const* im, float* const* time,
+    const SimdFFTTable<float>& table, float* work
+) noexcept {
+    constexpr size_t kLanes = kSimdBatchLanes;
+    const size_t h = static_cast<size_t>(n / 2);
+    float* xr = work;
+    float* xi = work + h * kLanes;
+    float* yr = work + 2 * h * kLanes;
+    float* yi = work + 3 * h * kLanes;
+    GatherSplit(h, count, re, im, xr, xi);
+    for (size_t c = 0; c < count; ++c) {
+        xi[c] = re[c][h];
+    }
+    const float* wr = table.RealTwiddle();
+    RealBackwardBatch(h, wr, wr + h, 2.0f / static_cast<float>(n), xr, xi);
+    if (Stockham<true>(h, kLanes, table.Twiddle(), xr, xi, yr, yi)) {
+        std::swap(xr, yr);
+        std::swap(xi, yi);
+    }
+    ScatterInterleaved(h, count, xr, xi, time, 0, 1.0f);
+}
+
+void simd_cdft_batch(
+    int n, bool inverse, size_t count, const float* const* in, float* const* out,
+    size_t in_rotate, size_t out_rotate, float scale,
+    const SimdFFTTable<float>& table, float* work
+) noexcept {
+    constexpr size_t kLanes = kSimdBatchLanes;
+    const size_t cn = static_cast<size_t>(n);
+    float* xr = work;
+    float* xi = work + cn * kLanes;
+    float* yr = work + 2 * cn * kLanes;
+    float* yi = work + 3 * cn * kLanes;
+    GatherInterleaved(cn, count, in, in_rotate, xr, xi);
+    bool const in_y = inverse
+        ? Stockham<true>(cn, kLanes, table.Twiddle(), xr, xi, yr, yi)
+        : Stockham<false>(cn, kLanes, table.Twiddle(), xr, xi, yr, yi);
+    if (in_y) {
+        std::swap(xr, yr);
+        std::swap(xi, yi);
+    }
+    ScatterInterleaved(cn, count, xr, xi, out, out_rotate, scale);
+}
+
+// --------------------------------------------------------------------------------
+// mixed radix
+// --------------------------------------------------------------------------------
+
+template<class T>
+void MixedFFTTable<T>::Init(size_t n, bool real) {
+    complex_size_ = real ? n / 2 : n;
+
+    stages_.clear();
+    size_t rest = complex_size_;
+    for (size_t radix : {4, 2, 3, 5, 7}) {
+        while (rest % radix == 0) {
+            stages_.push_back({radix, 0});
+            rest /= radix;
+        }
+    }
+
+    bluestein_size_ = 0;
+    twiddle_.clear();
+    chirp_.clear();
+    chirp_spectrum_.clear();
+    chirp_spectrum_inverse_.clear();
+    if (rest == 1) {
+        size_t num_twiddle = 0;
+        size_t len = complex_size_;
+        for (auto& stage : stages_) {
+            stage.len = len;
+            num_twiddle += 2 * (stage.radix - 1) * (len / stage.radix);
+            len /= stage.radix;
+        }
+        twiddle_.resize(num_twiddle);
+        T* tw = twiddle_.data();
+        for (auto const& stage : stages_) {
+            const size_t m = stage.len / stage.radix;
+            const double theta = 2.0 * std::numbers::pi / static_cast<double>(stage.len);
+            for (size_t k = 1; k < stage.radix; ++k) {
+                for (size_t p = 0; p < m; ++p) {
+                    const double phase = theta * static_cast<double>(k * p);
+                    tw[(2 * k - 2) * m + p] = static_cast<T>(std::cos(phase));
+                    tw[(2 * k - 1) * m + p] = static_cast<T>(-std::sin(phase));
+                }
+            }
+            tw += 2 * (stage.radix - 1) * m;
+        }
+    }
+    else {
+        // 有大于7的质因子
+        stages_.clear();
+        const size_t cn = complex_size_;
+        bluestein_size_ = 1;
+        while (bluestein_size_ < 2 * cn - 1) {
+            bluestein_size_ *= 2;
+        }
+        const size_t big = bluestein_size_;
+        bluestein_table_.Init(big, false);
+
+        chirp_.resize(2 * cn);
+        for (size_t k = 0; k < cn; ++k) {
+            // k^2 mod 2n避免相位过大丢失精度
+            const unsigned long long k2 = (static_cast<unsigned long long>(k) * k) % (2ull * cn);
+            const double phase = std::numbers::pi * static_cast<double>(k2) / static_cast<double>(cn);
+            chirp_[k] = static_cast<T>(std::cos(phase));
+            chirp_[cn + k] = static_cast<T>(-std::sin(phase));
+        }
+
+        // 卷积核conj(c[k])，c[k]，在M-k处回绕
+        std::vector<T> work(4 * big);
+        auto make_spectrum = [&](std::vector<T>& spectrum, T imag_sign) {
+            T* xr = work.data();
+            T* xi = xr + big;
+            T* yr = xr + 2 * big;
+            T* yi = xr + 3 * big;
+            std::fill(work.begin(), work.end(), 0.0f);
+            for (size_t k = 0; k < cn; ++k) {
+                xr[k] = chirp_[k];
+                xi[k] = imag_sign * chirp_[cn + k];
+                if (k != 0) {
+                    xr[big - k] = xr[k];
+                    xi[big - k] = xi[k];
+                }
+            }
+            if (Stockham<false>(big, 1, bluestein_table_.Twiddle(), xr, xi, yr, yi)) {
+                std::swap(xr, yr);
+                std::swap(xi, yi);
+            }
+            const T gain = T(1) / static_cast<T>(big);
+            spectrum.resize(2 * big);
+            for (size_t k = 0; k < big; ++k) {
+                spectrum[k] = xr[k] * gain;
+                spectrum[big + k] = xi[k] * gain;
+            }
+        };
+        make_spectrum(chirp_spectrum_, -1.0f);
+        make_spectrum(chirp_spectrum_inverse_, 1.0f);
+    }
+
+    if (real) {
+        const size_t h = n / 2;
+        real_twiddle_.resize(2 * h);
+        const double theta = 2.0 * std::numbers::pi / static_cast<double>(n);
+        for (size_t k = 0; k < h; ++k) {
+            real_twiddle_[k] = static_cast<T>(std::cos(theta * static_cast<double>(k)));
+            real_twiddle_[h + k] = static_cast<T>(-std::sin(theta * static_cast<double>(k)));
+        }
+    }
+    else {
+        real_twiddle_.clear();
+    }
+}
+
+template<class T>
+void mixed_cdft(int n, int isgn, T* a, const MixedFFTTable<T>& table, T* work) noexcept {
+    const size_t cn = static_cast<size_t>(n / 2);
+    T* xr = work;
+    T* xi = work + cn;
+    T* yr = work + 2 * cn;
+    T* yi = work + 3 * cn;
+    T* extra = work + 4 * cn;
+    Deinterleave(cn, a, xr, xi);
+    bool const in_y = isgn >= 0
+        ? MixedCore<true>(table, xr, xi, yr, yi, extra)
+        : MixedCore<false>(table, xr, xi, yr, yi, extra);
+    if (in_y) {
+        Interleave(cn, yr, yi, a);
+    }
+    else {
+        Interleave(cn, xr, xi, a);
+    }
+}
+
+template<class T>
+void mixed_rdft(int n, int isgn, T* a, const MixedFFTTable<T>& table, T* work) noexcept {
+    const size_t h = static_cast<size_t>(n / 2);
+    T* extra = work + 4 * h;
+    if (isgn >= 0) {
+        RealFFTForward(static_cast<size_t>(n), a, PackedBins<T>{a}, table.RealTwiddle(), [&](T* xr, T* xi, T* yr, T* yi) {
+            return MixedCore<false>(table, xr, xi, yr, yi, extra);
+        }, work);
+    }
+    else {
+        RealFFTBackward(static_cast<size_t>(n), PackedBins<T>{a}, a, T(1), table.RealTwiddle(), [&](T* xr, T* xi, T* yr, T* yi) {
+            return MixedCore<true>(table, xr, xi, yr, yi, extra);
+        }, work);
+    }
+}
+
+template class SimdFFTTable<float>;
+template class SimdFFTTable<double>;
+template class MixedFFTTable<float>;
+template class MixedFFTTable<double>;
+
+#define QWQDSP_SIMD_FFT_INSTANTIATE(T) \
+    template void simd_cdft<T>(int, int, T*, const SimdFFTTable<T>&, T*) noexcept; \
+    template void simd_rdft<T>(int, int, T*, const SimdFFTTable<T>&, T*) noexcept; \
+    template void simd_rdft_split<T>(int, const T*, T*, T*, const SimdFFTTable<T>&, T*) noexcept; \
+    template void simd_irdft_split<T>(int, const T*, const T*, T*, const SimdFFTTable<T>&, T*) noexcept; \
+    template void mixed_cdft<T>(int, int, T*, const MixedFFTTable<T>&, T*) noexcept; \
+    template void mixed_rdft<T>(int, int, T*, const MixedFFTTable<T>&, T*) noexcept;
+
+QWQDSP_SIMD_FFT_INSTANTIATE(float)
+QWQDSP_SIMD_FFT_INSTANTIATE(double)
+#undef QWQDSP_SIMD_FFT_INSTANTIATE
+}
\ No newline at end of file
@@ -0,0 +1,178 @@
+#include "qwqdsp/filter/internal/simd_fir.hpp"
+
+#include <algorithm>
+
+#include "qwqdsp/spectral/simd_ops.hpp"
+
+namespace qwqdsp::filter::internal {
+// --------------------------------------------------------------------------------
+// 直接型FIR
+// --------------------------------------------------------------------------------
+
+namespace {
+#if defined(QWQDSP_FFT_HAS_AVX)
+using LaneOps = spectral::internal::AvxOps<float>;
+#elif defined(QWQDSP_FFT_HAS_SSE)
+using LaneOps = spectral::internal::SseOps<float>;
+#else
+using LaneOps = spectral::internal::ScalarOps<float>;
+#endif
+
+/**
+ * @brief 从begin开始的4个向量的输出，begin[v]之间可以重叠
+ */
+template<class Ops>
+void FirTile4(
+    size_t num_taps, const float* coeff, const float* history, float* output,
+    const size_t (&begin)[4]
+) noexcept {
+    auto acc0 = Ops::Set1(0.0f);
+    auto acc1 = Ops::Set1(0.0f);
+    auto acc2 = Ops::Set1(0.0f);
+    auto acc3 = Ops::Set1(0.0f);
+    const float* x0 = history + begin[0];
+    const float* x1 = history + begin[1];
+    const float* x2 = history + begin[2];
+    const float* x3 = history + begin[3];
+    for (size_t j = 0; j < num_taps; ++j) {
+        const auto c = Ops::Set1(coeff[j]);
+        acc0 = Ops::MulAdd(c, Ops::Load(x0 + j), acc0);
+        acc1 = Ops::MulAdd(c, Ops::Load(x1 + j), acc1);
+        acc2 = Ops::MulAdd(c, Ops::Load(x2 + j), acc2);
+        acc3 = Ops::MulAdd(c, Ops::Load(x3 + j), acc3);
+    }
+    Ops::Store(output + begin[0], acc0);
+    Ops::Store(output + begin[1], acc1);
+    Ops::Store(output + begin[2], acc2);
+    Ops::Store(output + begin[3], acc3);
+}
+}
+
+void simd_fir(
+    size_t num_taps, size_t num_outputs,
+    const float* coeff, const float* history, float* output
+) noexcept {
+    using Ops = LaneOps;
+    constexpr size_t kWidth = Ops::kWidth;
+    size_t i = 0;
+    // 4个向量的输出共用一次系数广播，相邻的输出读的是错开一个采样的输入
+    for (; i + 4 * kWidth <= num_outputs; i += 4 * kWidth) {
+        const size_t begin[4]{i, i + kWidth, i + 2 * kWidth, i + 3 * kWidth};
+        FirTile4<Ops>(num_taps, coeff, history, output, begin);
+    }
+    if (i < num_outputs && num_outputs >= kWidth) {
+        // 剩下不到4个向量，最后一个向量和前面重叠，4个累加器互相独立，只需要再扫一遍系数
+        const size_t last = num_outputs - kWidth;
+        const size_t begin[4]{
+            std::min(i, last), std::min(i + kWidth, last),
+            std::min(i + 2 * kWidth, last), last
+        };
+        FirTile4<Ops>(num_taps, coeff, history, output, begin);
+        i = num_outputs;
+    }
+    for (; i < num_outputs; ++i) {
+        float sum = 0.0f;
+        const float* x = history + i;
+        for (size_t j = 0; j < num_taps; ++j) {
+            sum += coeff[j] * x[j];
+        }
+        output[i] = sum;
+    }
+}
+
+namespace {
+template<class Ops, size_t kStep>
+void FirSymmetricTile4(
+    size_t num_taps, size_t step, const float* coeff, const float* history, float* output,
+    const size_t (&begin)[4]
+) noexcept {
+    // 常用的step是编译期常量，地址的递增可以直接用立即数
+    if constexpr (kStep != 0) {
+        step = kStep;
+    }
+    auto acc0 = Ops::Set1(0.0f);
+    auto acc1 = Ops::Set1(0.0f);
+    auto acc2 = Ops::Set1(0.0f);
+    auto acc3 = Ops::Set1(0.0f);
+    const float* x0 = history + begin[0];
+    const float* x1 = history + begin[1];
+    const float* x2 = history + begin[2];
+    const float* x3 = history + begin[3];
+    const size_t num_pairs = num_taps / 2;
+    size_t a = 0;
+    size_t b = (num_taps - 1) * step;
+    for (size_t j = 0; j < num_pairs; ++j) {
+        const auto c = Ops::Set1(coeff[j]);
+        acc0 = Ops::MulAdd(c, Ops::Add(Ops::Load(x0 + a), Ops::Load(x0 + b)), acc0);
+        acc1 = Ops::MulAdd(c, Ops::Add(Ops::Load(x1 + a), Ops::Load(x1 + b)), acc1);
+        acc2 = Ops::MulAdd(c, Ops::Add(Ops::Load(x2 + a), Ops::Load(x2 + b)), acc2);
+        acc3 = Ops::MulAdd(c, Ops::Add(Ops::Load(x3 + a), Ops::Load(x3 + b)), acc3);
+        a += step;
+        b -= step;
+    }
+    if (num_taps % 2 == 1) {
+        // 奇数长度的中心抽头，这时a == b
+        const auto c = Ops::Set1(coeff[num_pairs]);
+        acc0 = Ops::MulAdd(c, Ops::Load(x0 + a), acc0);
+        acc1 = Ops::MulAdd(c, Ops::Load(x1 + a), acc1);
+        acc2 = Ops::MulAdd(c, Ops::Load(x2 + a), acc2);
+        acc3 = Ops::MulAdd(c, Ops::Load(x3 + a), acc3);
+    }
+    Ops::Store(output + begin[0], acc0);
+    Ops::Store(output + begin[1], acc1);
+    Ops::Store(output + begin[2], acc2);
+    Ops::Store(output + begin[3], acc3);
+}
+
+template<class Ops, size_t kStep>
+void FirSymmetric(
+    size_t num_taps, size_t step, size_t num_outputs,
+    const float* coeff, const float* history, float* output
+) noexcept {
+    constexpr size_t kWidth = Ops::kWidth;
+    size_t i = 0;
+    for (; i + 4 * kWidth <= num_outputs; i += 4 * kWidth) {
+        const size_t begin[4]{i, i + kWidth, i + 2 * kWidth, i + 3 * kWidth};
+        FirSymmetricTile4<Ops, kStep>(num_taps, step, coeff, history, output, begin);
+    }
+    if (i < num_outputs && num_outputs >= kWidth) {
+        const size_t last = num_outputs - kWidth;
+        const size_t begin[4]{
+            std::min(i, last), std::min(i + kWidth, last),
+            std::min(i + 2 * kWidth, last), last
+        };
+        FirSymmetricTile4<Ops, kStep>(num_taps, step, coeff, history, output, begin);
+        i = num_outputs;
+    }
+    const size_t num_pairs = num_taps / 2;
+    for (; i < num_outputs; ++i) {
+        float sum = 0.0f;
+        const float* x = history + i;
+        for (size_t j = 0; j < num_pairs; ++j) {
+            sum += coeff[j] * (x[j * step] + x[(num_taps - 1 - j) * step]);
+        }
+        if (num_taps % 2 == 1) {
+            sum += coeff[num_pairs] * x[num_pairs * step];
+        }
+        output[i] = sum;
+    }
+}
+}
+
+void simd_fir_symmetric(
+    size_t num_taps, size_t step, size_t num_outputs,
+    const float* coeff, const float* history, float* output
+) noexcept {
+    switch (step) {
+    case 1:
+        FirSymmetric<LaneOps, 1>(num_taps, step, num_outputs, coeff, history, output);
+        break;
+    case 2:
+        FirSymmetric<LaneOps, 2>(num_taps, step, num_outputs, coeff, history, output);
+        break;
+    default:
+        FirSymmetric<LaneOps, 0>(num_taps, step, num_outputs, coeff, history, output);
+        break;
+    }
+}
+}
\ No newline at end of file
@@ -0,0 +1,78 @@
+#include "qwqdsp/spectral/simd_mac.hpp"
+
+#include "qwqdsp/spectral/simd_ops.hpp"
+
+namespace qwqdsp::spectral::internal {
+// --------------------------------------------------------------------------------
+// 频谱的复数乘加
+// --------------------------------------------------------------------------------
+
+namespace {
+#if defined(QWQDSP_FFT_HAS_AVX)
+using LaneOps = AvxOps<float>;
+#elif defined(QWQDSP_FFT_HAS_SSE)
+using LaneOps = SseOps<float>;
+#else
+using LaneOps = ScalarOps<float>;
+#endif
+}
+
+void simd_complex_mac(
+    size_t num_bins, size_t num_partitions, size_t stride,
+    const float* x, const float* h, float* yr, float* yi, bool accumulate
+) noexcept {
+    using Ops = LaneOps;
+    constexpr size_t kWidth = Ops::kWidth;
+    const size_t half = stride / 2;
+    size_t i = 0;
+    // 两个向量一组，所有分区的结果留在寄存器里，实部的两项分开累加避免依赖取反
+    for (; i + 2 * kWidth <= num_bins; i += 2 * kWidth) {
+        auto re_pos0 = accumulate ? Ops::Load(yr + i) : Ops::Set1(0.0f);
+        auto re_pos1 = accumulate ? Ops::Load(yr + i + kWidth) : Ops::Set1(0.0f);
+        auto im0 = accumulate ? Ops::Load(yi + i) : Ops::Set1(0.0f);
+        auto im1 = accumulate ? Ops::Load(yi + i + kWidth) : Ops::Set1(0.0f);
+        auto re_neg0 = Ops::Set1(0.0f);
+        auto re_neg1 = Ops::Set1(0.0f);
+        const float* px = x + i;
+        const float* ph = h + i;
+        for (size_t p = 0; p < num_partitions; ++p) {
+            const auto xr0 = Ops::Load(px);
+            const auto xr1 = Ops::Load(px + kWidth);
+            const auto xi0 = Ops::Load(px + half);
+            const auto xi1 = Ops::Load(px + half + kWidth);
+            const auto hr0 = Ops::Load(ph);
+            const auto hr1 = Ops::Load(ph + kWidth);
+            const auto hi0 = Ops::Load(ph + half);
+            const auto hi1 = Ops::Load(ph + half + kWidth);
+            re_pos0 = Ops::MulAdd(xr0, hr0, re_pos0);
+            re_pos1 = Ops::MulAdd(xr1, hr1, re_pos1);
+            re_neg0 = Ops::MulAdd(xi0, hi0, re_neg0);
+            re_neg1 = Ops::MulAdd(xi1, hi1, re_neg1);
+            im0 = Ops::MulAdd(xr0, hi0, im0);
+            im1 = Ops::MulAdd(xr1, hi1, im1);
+            im0 = Ops::MulAdd(xi0, hr0, im0);
+            im1 = Ops::MulAdd(xi1, hr1, im1);
+            px += stride;
+            ph += stride;
+        }
+        Ops::Store(yr + i, Ops::Sub(re_pos0, re_neg0));
+        Ops::Store(yr + i + kWidth, Ops::Sub(re_pos1, re_neg1));
+        Ops::Store(yi + i, im0);
+        Ops::Store(yi + i + kWidth, im1);
+    }
+    for (; i < num_bins; ++i) {
+        float re = accumulate ? yr[i] : 0.0f;
+        float im = accumulate ? yi[i] : 0.0f;
+        const float* px = x + i;
+        const float* ph = h + i;
+        for (size_t p = 0; p < num_partitions; ++p) {
+            re += px[0] * ph[0] - px[half] * ph[half];
+            im += px[0] * ph[half] + px[half] * ph[0];
+            px += stride;
+            ph += stride;
+        }
+        yr[i] = re;
+        yi[i] = im;
+    }
+}
+}
\ No newline at end of file